@@ -0,0 +1,151 @@
+#include "admin_socket.h"
+#include "affinity.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Соединение без команд дольше этого времени закрывается
+static const int ADMIN_IDLE_TIMEOUT_MS = 30000;
+static const size_t ADMIN_MAX_LINE = 4096;
+
+AdminSocket::AdminSocket(Logger& logger, CommandHandler handler)
+    : logger_(logger), handler_(std::move(handler)), socket_(-1), inode_(0), stopping_(false) {
+}
+
+AdminSocket::~AdminSocket() {
+    stop();
+}
+
+bool AdminSocket::start(const std::string& path) {
+    struct sockaddr_un address;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        logger_.error("Invalid admin socket path: " + path);
+        return false;
+    }
+
+    socket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socket_ < 0) {
+        logger_.error("Failed to create admin socket: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+
+    // Управлять сервером может только владелец процесса
+    mode_t oldMask = umask(0077);
+    int bound = bind(socket_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    umask(oldMask);
+
+    struct stat info;
+    if (bound < 0 || listen(socket_, 4) < 0 || stat(path.c_str(), &info) != 0) {
+        logger_.error("Failed to open admin socket " + path + ": " + std::string(strerror(errno)));
+        close(socket_);
+        socket_ = -1;
+        return false;
+    }
+
+    path_ = path;
+    inode_ = info.st_ino;
+    stopping_ = false;
+    thread_ = std::thread(&AdminSocket::acceptLoop, this);
+    logger_.info("Admin socket listening on " + path);
+    return true;
+}
+
+void AdminSocket::stop() {
+    if (socket_ < 0) {
+        return;
+    }
+
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(socket_);
+    socket_ = -1;
+
+    struct stat info;
+    if (stat(path_.c_str(), &info) == 0 && info.st_ino == inode_) {
+        unlink(path_.c_str());
+    }
+}
+
+void AdminSocket::acceptLoop() {
+    nameCurrentThread("vcalc-admin");
+    while (!stopping_) {
+        struct pollfd pfd = {socket_, POLLIN, 0};
+        int ready = poll(&pfd, 1, 500);
+        if (ready <= 0) {
+            continue;
+        }
+
+        int connection = accept4(socket_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            continue;
+        }
+        serveConnection(connection);
+        close(connection);
+    }
+}
+
+void AdminSocket::serveConnection(int connection) {
+    std::string buffer;
+    char chunk[512];
+
+    while (!stopping_) {
+        size_t newline;
+        while ((newline = buffer.find('\n')) != std::string::npos) {
+            std::string command = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (!command.empty() && command.back() == '\r') {
+                command.pop_back();
+            }
+            if (command.empty()) {
+                continue;
+            }
+            if (command == "quit") {
+                return;
+            }
+
+            logger_.info("Admin command: " + command);
+            std::string reply = handler_(command);
+            if (reply.empty() || reply.back() != '\n') {
+                reply += '\n';
+            }
+            size_t sent = 0;
+            while (sent < reply.size()) {
+                ssize_t n = send(connection, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    return;
+                }
+                sent += static_cast<size_t>(n);
+            }
+        }
+
+        if (buffer.size() > ADMIN_MAX_LINE) {
+            return;
+        }
+
+        struct pollfd pfd = {connection, POLLIN, 0};
+        if (poll(&pfd, 1, ADMIN_IDLE_TIMEOUT_MS) <= 0) {
+            return;
+        }
+        ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            // Последняя команда может прийти без перевода строки
+            if (!buffer.empty()) {
+                buffer += '\n';
+                continue;
+            }
+            return;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+}
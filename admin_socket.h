@@ -0,0 +1,42 @@
+#ifndef ADMIN_SOCKET_H
+#define ADMIN_SOCKET_H
+
+#include "logger.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <sys/types.h>
+
+// Локальный административный сокет. Команды читаются построчно в отдельном
+// потоке и передаются обработчику; ответ обработчика отправляется клиенту.
+// Поток не участвует в обработке запросов клиентов.
+class AdminSocket {
+public:
+    typedef std::function<std::string(const std::string&)> CommandHandler;
+
+private:
+    Logger& logger_;
+    CommandHandler handler_;
+    std::string path_;
+    int socket_;
+    ino_t inode_;  // Чтобы не удалить сокет, который уже занял новый процесс
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+
+public:
+    AdminSocket(Logger& logger, CommandHandler handler);
+    ~AdminSocket();
+
+    AdminSocket(const AdminSocket&) = delete;
+    AdminSocket& operator=(const AdminSocket&) = delete;
+
+    bool start(const std::string& path);
+    void stop();
+
+private:
+    void acceptLoop();
+    void serveConnection(int connection);
+};
+
+#endif // ADMIN_SOCKET_H
@@ -0,0 +1,149 @@
+#include "affinity.h"
+#include "error_handler.h"
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <cstdlib>
+#include <cstring>
+#include <sys/syscall.h>
+
+// Константа из <numaif.h>: не тянем libnuma ради одного системного вызова
+static const int MPOL_PREFERRED_POLICY = 1;
+static const int MAX_NUMA_NODES = 1024;
+
+// Узел процессора из sysfs (каталог cpuN содержит ссылку nodeM); -1, если неизвестен
+static int cpuNode(int cpu) {
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* directory = opendir(path.c_str());
+    if (directory == nullptr) {
+        return -1;
+    }
+    int node = -1;
+    while (struct dirent* entry = readdir(directory)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(directory);
+    return node;
+}
+
+// Общий NUMA-узел всех процессоров списка; -1, если узлов несколько или он неизвестен
+static int commonNode(const CpuList& cpus) {
+    int node = -1;
+    for (int cpu : cpus) {
+        int cpuNodeId = cpuNode(cpu);
+        if (cpuNodeId < 0 || (node >= 0 && cpuNodeId != node)) {
+            return -1;
+        }
+        node = cpuNodeId;
+    }
+    return node;
+}
+
+CpuList parseCpuList(const std::string& spec) {
+    CpuList cpus;
+    size_t start = 0;
+
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string item = spec.substr(start, end - start);
+        if (item.empty()) {
+            throw ConfigException("Invalid CPU list: " + spec);
+        }
+
+        try {
+            size_t dash = item.find('-');
+            std::string firstPart = item.substr(0, dash);
+            std::string lastPart = dash != std::string::npos ? item.substr(dash + 1) : firstPart;
+            size_t firstLength = 0;
+            size_t lastLength = 0;
+            int first = std::stoi(firstPart, &firstLength);
+            int last = std::stoi(lastPart, &lastLength);
+            if (firstLength != firstPart.size() || lastLength != lastPart.size() ||
+                first < 0 || last < first || last >= CPU_SETSIZE) {
+                throw ConfigException("Invalid CPU range: " + item);
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::invalid_argument&) {
+            throw ConfigException("Invalid CPU list: " + spec);
+        } catch (const std::out_of_range&) {
+            throw ConfigException("Invalid CPU list: " + spec);
+        }
+
+        start = end + 1;
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string formatCpuList(const CpuList& cpus) {
+    std::string result;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        if (i > 0) {
+            result += ",";
+        }
+        result += std::to_string(cpus[i]);
+    }
+    return result.empty() ? "any" : result;
+}
+
+bool pinCurrentThread(const CpuList& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return false;
+    }
+
+    // Память - с узла выбранных процессоров. MPOL_PREFERRED, а не MPOL_BIND:
+    // когда память узла кончится, выделение уйдет на соседний узел, а не
+    // завершится ошибкой. Если процессоры на разных узлах, остается политика
+    // процесса. Ошибка здесь не критична: на машине без NUMA политика не нужна.
+    int node = commonNode(cpus);
+    if (node >= 0 && node < MAX_NUMA_NODES) {
+        unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {};
+        mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_set_mempolicy, MPOL_PREFERRED_POLICY, mask, MAX_NUMA_NODES);
+    }
+    return true;
+}
+
+void nameCurrentThread(const std::string& name) {
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+}
+
+int currentCpu() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return -1;
+    }
+    return static_cast<int>(cpu);
+}
+
+int currentNumaNode() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return -1;
+    }
+    return static_cast<int>(node);
+}
@@ -0,0 +1,26 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <string>
+#include <vector>
+
+// Привязка потоков к процессорам и NUMA-узлам.
+// Пустой список процессоров означает "без привязки".
+typedef std::vector<int> CpuList;
+
+// Разбор списка вида "0-3,8,10-11"; при ошибке бросает ConfigException
+CpuList parseCpuList(const std::string& spec);
+std::string formatCpuList(const CpuList& cpus);
+
+// Привязывает текущий поток к процессорам; если все они на одном NUMA-узле,
+// поток выделяет память с этого узла (MPOL_PREFERRED)
+bool pinCurrentThread(const CpuList& cpus);
+
+// Имя потока в top -H, /proc/PID/task/*/comm и стеках профилировщика;
+// длиннее 15 символов обрезается
+void nameCurrentThread(const std::string& name);
+
+int currentCpu();
+int currentNumaNode();
+
+#endif // AFFINITY_H
@@ -4,16 +4,20 @@
 #include <algorithm>
 
 #include <cryptopp/sha.h>
+#include <cryptopp/hmac.h>
 #include <cryptopp/hex.h>
 #include <cryptopp/osrng.h>
 #include <cryptopp/filters.h>
 
 using namespace CryptoPP;
 
-Authenticator::Authenticator(Logger& logger) : logger_(logger) {
+Authenticator::Authenticator(Logger& logger)
+    : users_(std::make_shared<const UserMap>()), logger_(logger) {
 }
 
 bool Authenticator::loadUsers(const std::string& filename) {
+    databaseFile_ = filename;
+    auto users = std::make_shared<UserMap>();
     std::ifstream file(filename);
     if (!file.is_open()) {
         logger_.error("Cannot open user database file: " + filename);
@@ -41,7 +45,7 @@ bool Authenticator::loadUsers(const std::string& filename) {
             password.erase(password.find_last_not_of(" \t") + 1);
             
             if (!login.empty() && !password.empty()) {
-                users_[login] = password;
+                (*users)[login] = password;
                 userCount++;
                 logger_.debug("Loaded user: " + login);
             } else {
@@ -59,52 +63,150 @@ bool Authenticator::loadUsers(const std::string& filename) {
         return false;
     }
     
+    std::atomic_store(&users_, std::shared_ptr<const UserMap>(users));
     logger_.info("Loaded " + std::to_string(userCount) + " users from database: " + filename);
     return true;
 }
 
+bool Authenticator::reloadUsers() {
+    if (shared_) {
+        logger_.warning("User database is shared between processes and cannot be reloaded");
+        return false;
+    }
+    return loadUsers(databaseFile_);
+}
+
+size_t Authenticator::userCount() const {
+    if (shared_) {
+        return shared_->size();
+    }
+    return std::atomic_load(&users_)->size();
+}
+
+bool Authenticator::shareUsers() {
+    std::unique_ptr<SharedUserTable> table(new SharedUserTable());
+    if (!table->build(*std::atomic_load(&users_))) {
+        logger_.error("Failed to place user database into shared memory: " + std::string(strerror(errno)));
+        return false;
+    }
+    logger_.info("User database shared read-only between processes: " +
+                 std::to_string(table->size()) + " users, " + std::to_string(table->bytes()) + " bytes");
+    shared_ = std::move(table);
+    std::atomic_store(&users_, std::make_shared<const UserMap>());
+    return true;
+}
+
+bool Authenticator::findPassword(const std::string& login, std::string& password) const {
+    if (shared_) {
+        return shared_->find(login, password);
+    }
+    auto users = std::atomic_load(&users_);
+    auto it = users->find(login);
+    if (it == users->end()) {
+        return false;
+    }
+    password = it->second;
+    return true;
+}
+
 bool Authenticator::userExists(const std::string& login) const {
-    return users_.find(login) != users_.end();
+    std::string password;
+    return findPassword(login, password);
 }
 
-bool Authenticator::authenticateUser(int clientSocket, const std::string& login) {
-    logger_.info("Authentication attempt for user: " + login);
+bool Authenticator::authenticateUser(Transport& transport, int clientSocket, const std::string& login) {
+    logger_.logf(LogLevel::INFO, LogFormat::AUTH_ATTEMPT, {login});
     
     // Проверка существования пользователя
-    if (!userExists(login)) {
+    std::string password;
+    if (!findPassword(login, password)) {
         logger_.warning("User not found: " + login);
-        return sendResult(clientSocket, false);
+        return sendResult(transport, clientSocket, false);
     }
     
     // Генерация и отправка соли
     std::string salt = generateSalt();
-    if (!sendSalt(clientSocket, salt)) {
+    if (!sendSalt(transport, clientSocket, salt)) {
         logger_.error("Failed to send salt to client");
         return false;
     }
     
     // Получение хеша от клиента
     std::string clientHash;
-    if (!receiveHash(clientSocket, clientHash)) {
+    if (!receiveHash(transport, clientSocket, clientHash)) {
         logger_.error("Failed to receive hash from client");
         return false;
     }
     
     // Проверка хеша
-    auto it = users_.find(login);
-    std::string expectedHash = calculateHash(salt, it->second);
+    std::string expectedHash = calculateHash(salt, password);
     
     bool authenticated = (clientHash == expectedHash);
     
     if (authenticated) {
-        logger_.info("User authenticated successfully: " + login);
+        logger_.logf(LogLevel::INFO, LogFormat::USER_AUTHENTICATED, {login});
     } else {
         logger_.warning("Authentication failed for user: " + login);
         logger_.debug("Expected hash: " + expectedHash);
         logger_.debug("Received hash: " + clientHash);
     }
     
-    return sendResult(clientSocket, authenticated);
+    return sendResult(transport, clientSocket, authenticated);
+}
+
+std::string Authenticator::calculateToken(const std::string& password, uint64_t timestamp,
+                                          const char* body, size_t bodySize) {
+    std::string data(8 + bodySize, '\0');
+    for (size_t i = 0; i < 8; ++i) {
+        data[i] = static_cast<char>(timestamp >> (8 * i));
+    }
+    memcpy(&data[8], body, bodySize);
+    
+    HMAC<SHA1> hmac(reinterpret_cast<const byte*>(password.data()), password.size());
+    std::string token;
+    StringSource(data, true,
+        new HashFilter(hmac,
+            new HexEncoder(
+                new StringSink(token)
+            )
+        )
+    );
+    
+    for (char& c : token) {
+        c = std::toupper(c);
+    }
+    
+    return token;
+}
+
+bool Authenticator::verifyToken(const std::string& login, uint64_t timestamp, uint32_t requestId,
+                                const std::string& token, const char* body, size_t bodySize,
+                                uint64_t now, uint64_t maxSkewSeconds) {
+    uint64_t skew = timestamp > now ? timestamp - now : now - timestamp;
+    if (skew > maxSkewSeconds) {
+        return false;
+    }
+    
+    std::string password;
+    if (!findPassword(login, password)) {
+        return false;
+    }
+    
+    // Повтор проверяется только после подписи: чужие датаграммы не должны
+    // занимать место в списке принятых
+    if (calculateToken(password, timestamp, body, bodySize) != token) {
+        return false;
+    }
+    
+    // Записи старше окна уже не пройдут проверку метки времени
+    while (!seenTokens_.empty() && std::get<0>(*seenTokens_.begin()) + maxSkewSeconds < now) {
+        seenTokens_.erase(seenTokens_.begin());
+    }
+    if (!seenTokens_.emplace(timestamp, login, requestId).second) {
+        logger_.warning("Replayed UDP datagram rejected for user: " + login);
+        return false;
+    }
+    return true;
 }
 
 std::string Authenticator::generateSalt() {
@@ -146,34 +248,32 @@ std::string Authenticator::calculateHash(const std::string& salt, const std::str
     return hash;
 }
 
-bool Authenticator::sendSalt(int clientSocket, const std::string& salt) {
-    ssize_t bytesSent = send(clientSocket, salt.c_str(), salt.length(), 0);
-    if (bytesSent != static_cast<ssize_t>(salt.length())) {
+bool Authenticator::sendSalt(Transport& transport, int clientSocket, const std::string& salt) {
+    if (!transport.sendData(clientSocket, salt.c_str(), salt.length())) {
         return false;
     }
-    logger_.debug("Sent salt to client: " + salt);
+    logger_.logf(LogLevel::DEBUG, LogFormat::SENT_SALT, {salt});
     return true;
 }
 
-bool Authenticator::receiveHash(int clientSocket, std::string& hash) {
+bool Authenticator::receiveHash(Transport& transport, int clientSocket, std::string& hash) {
     char buffer[41] = {0}; 
-    ssize_t bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
+    ssize_t bytesReceived = transport.receiveCredential(clientSocket, buffer, sizeof(buffer) - 1);
     
     if (bytesReceived <= 0) {
         return false;
     }
     
     hash.assign(buffer, bytesReceived);
-    logger_.debug("Received hash from client: " + hash);
+    logger_.logf(LogLevel::DEBUG, LogFormat::RECEIVED_HASH, {hash});
     return true;
 }
 
-bool Authenticator::sendResult(int clientSocket, bool success) {
+bool Authenticator::sendResult(Transport& transport, int clientSocket, bool success) {
     std::string response = success ? "OK" : "ERR";
-    ssize_t bytesSent = send(clientSocket, response.c_str(), response.length(), 0);
     
-    if (bytesSent == static_cast<ssize_t>(response.length())) {
-        logger_.debug("Sent authentication result: " + response);
+    if (transport.sendData(clientSocket, response.c_str(), response.length())) {
+        logger_.logf(LogLevel::DEBUG, LogFormat::SENT_AUTH_RESULT, {response});
         return true;
     }
     return false;
@@ -3,29 +3,69 @@
 
 #include <string>
 #include <unordered_map>
+#include <set>
+#include <tuple>
+#include <cstdint>
+#include <memory>
 #include <sys/socket.h> 
 #include <unistd.h>      
 #include "logger.h"
 #include "error_handler.h"
+#include "shared_user_table.h"
+#include "transport.h"
+
+typedef std::unordered_map<std::string, std::string> UserMap;
 
 class Authenticator {
 private:
-    std::unordered_map<std::string, std::string> users_;
+    // Таблица пользователей неизменяема: перезагрузка собирает новую и
+    // атомарно подменяет указатель, сессии дорабатывают со своей копией
+    std::shared_ptr<const UserMap> users_;
+    std::string databaseFile_;
+    // В многопроцессном режиме таблица переносится в общую память
+    std::unique_ptr<SharedUserTable> shared_;
     Logger& logger_;
     
+    // Принятые датаграммы (метка времени, логин, номер запроса) в пределах
+    // допустимого расхождения часов: повтор такой датаграммы отклоняется
+    std::set<std::tuple<uint64_t, std::string, uint32_t>> seenTokens_;
+    
 public:
     Authenticator(Logger& logger);
     
     bool loadUsers(const std::string& filename);
-    bool authenticateUser(int clientSocket, const std::string& login);
+    // Перечитывает файл, указанный в loadUsers; при ошибке остается старая таблица
+    bool reloadUsers();
+    size_t userCount() const;
+    
+    // Переносит загруженную таблицу в общую память только для чтения,
+    // которую унаследуют процессы после fork(). Перезагрузка после этого недоступна.
+    bool shareUsers();
+    
+    bool findPassword(const std::string& login, std::string& password) const;
+    bool authenticateUser(Transport& transport, int clientSocket, const std::string& login);
     bool userExists(const std::string& login) const;
     
+    // Проверка токена датаграммы: HMAC-SHA1 с ключом-паролем над меткой
+    // времени и телом датаграммы (номер запроса, размер, элементы), поэтому
+    // подменить данные под чужим токеном нельзя. Метка времени должна
+    // отличаться от текущего времени не больше чем на maxSkewSeconds,
+    // а пара (метка времени, номер запроса) - не повторяться.
+    bool verifyToken(const std::string& login, uint64_t timestamp, uint32_t requestId,
+                     const std::string& token, const char* body, size_t bodySize,
+                     uint64_t now, uint64_t maxSkewSeconds);
+    // Токен в верхнем регистре hex, используется и клиентом
+    static std::string calculateToken(const std::string& password, uint64_t timestamp,
+                                      const char* body, size_t bodySize);
+    
+    // Хеш SHA-1(соль + пароль) в верхнем регистре, используется и клиентом
+    static std::string calculateHash(const std::string& salt, const std::string& password);
+    
 private:
     std::string generateSalt();
-    std::string calculateHash(const std::string& salt, const std::string& password);
-    bool sendSalt(int clientSocket, const std::string& salt);
-    bool receiveHash(int clientSocket, std::string& hash);
-    bool sendResult(int clientSocket, bool success);
+    bool sendSalt(Transport& transport, int clientSocket, const std::string& salt);
+    bool receiveHash(Transport& transport, int clientSocket, std::string& hash);
+    bool sendResult(Transport& transport, int clientSocket, bool success);
 };
 
 #endif // AUTHENTICATOR_H
\ No newline at end of file
@@ -0,0 +1,407 @@
+#include "client.h"
+#include "protocol.h"
+#include "server.h"
+#include "transport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <endian.h>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Нагрузочный клиент: измеряет пропускную способность и задержку
+// сервера по TCP, Unix-сокету, кольцам в разделяемой памяти и UDP.
+// С --inproc сервер работает в том же процессе, сессии идут через
+// socketpair(): весь путь протокола без сетевого стека и внешнего процесса.
+
+struct BenchOptions {
+    std::string tcpAddress;
+    std::string unixPath;
+    std::string udpAddress;
+    std::string inprocDb;
+    std::string logFile = "/dev/null";
+    std::string mode = "classic";
+    ElementType type = ElementType::FLOAT32;
+    bool noDelay = false;
+    bool fastOpen = false;
+    std::string user = "user";
+    std::string password = "P@ssW0rd";
+    size_t totalVectors = 10000;
+    size_t vectorSize = 16;
+    size_t batch = MAX_VECTORS_PER_SESSION;
+    bool ioStats = false;
+};
+
+static void showUsage() {
+    std::cout << "Usage: vcalc-bench (--tcp HOST:PORT | --unix PATH | --udp HOST:PORT | --inproc DB) [OPTIONS]\n\n"
+              << "Options:\n"
+              << "  --inproc DB         Run the server in this process with user database DB\n"
+              << "  --log FILE          Server log for --inproc (default: /dev/null)\n"
+              << "  --mode MODE         classic (default), tagged, framed, framed-lz or\n"
+              << "                      shm (Unix socket or --inproc)\n"
+              << "  --type TYPE         Element type for framed modes: f32 (default), f64,\n"
+              << "                      i32, i64 or bf16\n"
+              << "  --vectors N         Total vectors to send (default: 10000)\n"
+              << "  --size N            Elements per vector (default: 16)\n"
+              << "  --batch N           Vectors per request batch (default: 100)\n"
+              << "  --user NAME         Login (default: user)\n"
+              << "  --password PASS     Password (default: P@ssW0rd)\n"
+              << "  --client-tcp LIST   Client TCP options: nodelay, fastopen (comma-separated)\n"
+              << "  --io-stats          With --inproc: server syscalls and malloc calls per\n"
+              << "                      vector, by session stage\n\n"
+              << "Classic mode opens a new session per batch (the protocol allows at most\n"
+              << "100 vectors per session); tagged mode opens a session per batch of any\n"
+              << "size; shm and framed (protocol v2, framed-lz compresses batches) modes\n"
+              << "keep one session for the whole run.\n"
+              << "--udp sends one datagram per vector, --mode is ignored.\n";
+}
+
+static void parseClientTcp(const std::string& list, BenchOptions& options) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = std::min(list.find(',', start), list.size());
+        std::string option = list.substr(start, end - start);
+        if (option == "nodelay") options.noDelay = true;
+        else if (option == "fastopen") options.fastOpen = true;
+        else throw std::invalid_argument("Unknown --client-tcp option: " + option);
+        start = end + 1;
+    }
+}
+
+static ElementType parseElementType(const std::string& name) {
+    for (uint8_t code = 0; code < static_cast<uint8_t>(ElementType::TYPE_COUNT); ++code) {
+        ElementType type = static_cast<ElementType>(code);
+        if (name == elementTypeName(type)) {
+            return type;
+        }
+    }
+    throw std::invalid_argument("Unknown element type: " + name);
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        }
+        if (arg == "--io-stats") {
+            options.ioStats = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--tcp") options.tcpAddress = value;
+        else if (arg == "--unix") options.unixPath = value;
+        else if (arg == "--udp") options.udpAddress = value;
+        else if (arg == "--inproc") options.inprocDb = value;
+        else if (arg == "--log") options.logFile = value;
+        else if (arg == "--mode") options.mode = value;
+        else if (arg == "--type") options.type = parseElementType(value);
+        else if (arg == "--vectors") options.totalVectors = std::stoul(value);
+        else if (arg == "--size") options.vectorSize = std::stoul(value);
+        else if (arg == "--batch") options.batch = std::stoul(value);
+        else if (arg == "--user") options.user = value;
+        else if (arg == "--password") options.password = value;
+        else if (arg == "--client-tcp") parseClientTcp(value, options);
+        else throw std::invalid_argument("Unknown option: " + arg);
+    }
+
+    int transports = !options.tcpAddress.empty() + !options.unixPath.empty() + !options.udpAddress.empty() +
+                     !options.inprocDb.empty();
+    if (transports != 1) {
+        throw std::invalid_argument("Exactly one of --tcp, --unix, --udp or --inproc is required");
+    }
+    if (options.ioStats && options.inprocDb.empty()) {
+        throw std::invalid_argument("--io-stats requires --inproc");
+    }
+    size_t maxSize = options.mode == "tagged" || options.mode.compare(0, 6, "framed") == 0
+                     ? MAX_TAGGED_VECTOR_SIZE : MAX_VECTOR_SIZE;
+    if (options.vectorSize == 0 || options.vectorSize > maxSize) {
+        throw std::invalid_argument("--size must be 1-" + std::to_string(maxSize));
+    }
+    if (options.batch == 0 || options.totalVectors == 0) {
+        throw std::invalid_argument("--batch and --vectors must be positive");
+    }
+    if (!options.udpAddress.empty()) {
+        options.mode = "udp";
+    } else if (options.mode == "classic") {
+        options.batch = std::min<size_t>(options.batch, MAX_VECTORS_PER_SESSION);
+    } else if (options.mode != "shm" && options.mode != "tagged" &&
+               options.mode != "framed" && options.mode != "framed-lz") {
+        throw std::invalid_argument("Unknown mode: " + options.mode);
+    }
+    if (options.type != ElementType::FLOAT32 && options.mode.compare(0, 6, "framed") != 0) {
+        throw std::invalid_argument("--type requires framed or framed-lz mode");
+    }
+    return true;
+}
+
+static void splitAddress(const std::string& address, std::string& host, uint16_t& port) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::invalid_argument("Address must be HOST:PORT: " + address);
+    }
+    host = address.substr(0, colon);
+    port = static_cast<uint16_t>(std::stoul(address.substr(colon + 1)));
+}
+
+// Сервер в том же процессе: каждое подключение - пара сокетов,
+// серверный конец обслуживается отдельным потоком, как сессия в server
+class InProcessServer {
+private:
+    Server server_;
+    SocketPairTransport transport_;
+    std::thread session_;
+
+public:
+    explicit InProcessServer(const ServerConfig& config) : server_(config) {}
+    ~InProcessServer() { finishSession(); }
+
+    bool start() { return server_.initializeLocal(); }
+    std::vector<IoCounters> ioTotals(uint64_t& vectors) { return server_.ioTotals(vectors); }
+
+    bool connect(VcalcClient& client) {
+        finishSession();
+        int serverEnd, clientEnd;
+        if (!transport_.open(serverEnd, clientEnd)) {
+            return false;
+        }
+        session_ = std::thread([this, serverEnd] { server_.serveLocal(transport_, serverEnd, "inproc"); });
+        client.adoptSocket(clientEnd);
+        return true;
+    }
+
+    // Сессия завершается, когда клиент закрывает свой конец
+    void finishSession() {
+        if (session_.joinable()) {
+            session_.join();
+        }
+    }
+};
+
+static std::unique_ptr<InProcessServer> g_inproc;
+
+template <typename T>
+static void appendLittleEndian(std::vector<uint8_t>& data, T value) {
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+#if __BYTE_ORDER == __BIG_ENDIAN
+    std::reverse(bytes, bytes + sizeof(T));
+#endif
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+// Пакет для --type: те же значения около единицы, у целых - 1 и -1
+// с небольшими множителями в начале вектора
+static void makeTypedBatch(ElementType type, size_t count, size_t size,
+                           std::vector<uint32_t>& sizes, std::vector<uint8_t>& data) {
+    sizes.assign(count, static_cast<uint32_t>(size));
+    data.clear();
+    data.reserve(count * size * elementWidth(type));
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            double real = 1.0 + static_cast<double>((i + j) % 7) * 0.001;
+            int32_t whole = j == 0 ? static_cast<int32_t>(2 + i % 3) : (i + j) % 13 == 0 ? -1 : 1;
+            switch (type) {
+                case ElementType::FLOAT64:
+                    appendLittleEndian(data, real);
+                    break;
+                case ElementType::INT32:
+                    appendLittleEndian(data, whole);
+                    break;
+                case ElementType::INT64:
+                    appendLittleEndian(data, static_cast<int64_t>(whole));
+                    break;
+                case ElementType::BFLOAT16: {
+                    float value = static_cast<float>(1.0 + static_cast<double>((i + j) % 7) * 0.01);
+                    uint32_t bits;
+                    memcpy(&bits, &value, sizeof(bits));
+                    appendLittleEndian(data, static_cast<uint16_t>(bits >> 16));
+                    break;
+                }
+                default:
+                    appendLittleEndian(data, static_cast<float>(real));
+                    break;
+            }
+        }
+    }
+}
+
+static bool connectClient(VcalcClient& client, const BenchOptions& options) {
+    if (g_inproc) {
+        return g_inproc->connect(client);
+    }
+    if (!options.unixPath.empty()) {
+        return client.connectUnix(options.unixPath);
+    }
+
+    std::string host;
+    uint16_t port;
+    splitAddress(options.tcpAddress, host, port);
+    return client.connectTcp(host, port);
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            showUsage();
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "vcalc-bench: " << e.what() << std::endl;
+        showUsage();
+        return 1;
+    }
+
+    if (!options.inprocDb.empty()) {
+        ServerConfig config;
+        config.clientDbFile = options.inprocDb;
+        config.logFile = options.logFile;
+        config.ioStats = options.ioStats;
+        g_inproc.reset(new InProcessServer(config));
+        if (!g_inproc->start()) {
+            std::cerr << "vcalc-bench: cannot start in-process server, see " << options.logFile << std::endl;
+            return 1;
+        }
+    }
+
+    // Значения около единицы, чтобы произведения не переполнялись
+    std::vector<std::vector<float>> batch(options.batch, std::vector<float>(options.vectorSize));
+    for (size_t i = 0; i < batch.size(); ++i) {
+        for (size_t j = 0; j < options.vectorSize; ++j) {
+            batch[i][j] = 1.0f + static_cast<float>((i + j) % 7) * 0.001f;
+        }
+    }
+
+    // Пакет другого типа для протокола v2 (--type)
+    bool typed = options.type != ElementType::FLOAT32;
+    std::vector<uint32_t> typedSizes;
+    std::vector<uint8_t> typedData;
+    std::vector<uint8_t> typedResults;
+    if (typed) {
+        makeTypedBatch(options.type, options.batch, options.vectorSize, typedSizes, typedData);
+    }
+
+    VcalcClient client;
+    client.setTcpOptions(options.noDelay, options.fastOpen);
+    std::vector<float> results;
+    std::vector<double> latencies;
+    // Подключение и вход отдельно от обмена векторами (классический и tagged режимы)
+    double handshakeMicros = 0.0;
+    size_t handshakes = 0;
+    size_t done = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    bool framed = options.mode == "framed" || options.mode == "framed-lz";
+    if (options.mode == "shm" || framed) {
+        if (!connectClient(client, options) || !client.login(options.user, options.password) ||
+            !(framed ? client.openFramed() : client.openSharedMemory())) {
+            std::cerr << "vcalc-bench: " << client.lastError() << std::endl;
+            return 1;
+        }
+    }
+
+    while (done < options.totalVectors) {
+        size_t count = std::min(options.batch, options.totalVectors - done);
+        batch.resize(count);
+        if (typed) {
+            typedSizes.resize(count);
+            typedData.resize(count * options.vectorSize * elementWidth(options.type));
+        }
+
+        auto batchStart = std::chrono::steady_clock::now();
+        bool ok;
+        if (options.mode == "shm") {
+            ok = client.computeProductsShm(batch, results);
+        } else if (typed) {
+            ok = client.computeProductsTyped(options.type, typedSizes, typedData, typedResults,
+                                             options.mode == "framed-lz");
+        } else if (framed) {
+            ok = client.computeProductsFramed(batch, results, options.mode == "framed-lz");
+        } else if (options.mode == "udp") {
+            std::string host;
+            uint16_t port;
+            splitAddress(options.udpAddress, host, port);
+            ok = client.computeProductsUdp(host, port, options.user, options.password, batch, results);
+        } else {
+            ok = connectClient(client, options) && client.login(options.user, options.password);
+            handshakeMicros += std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - batchStart).count();
+            handshakes++;
+            if (options.mode == "tagged") {
+                ok = ok && client.computeProductsTagged(batch, results);
+            } else {
+                ok = ok && client.computeProducts(batch, results);
+            }
+            client.disconnect();
+        }
+        if (!ok) {
+            std::cerr << "vcalc-bench: " << client.lastError() << std::endl;
+            return 1;
+        }
+
+        latencies.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - batchStart).count());
+        done += count;
+    }
+
+    client.disconnect();
+    if (g_inproc) {
+        g_inproc->finishSession();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    double mean = 0.0;
+    for (double latency : latencies) {
+        mean += latency;
+    }
+    mean /= latencies.size();
+    double p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    double megabytes = static_cast<double>(done * options.vectorSize * elementWidth(options.type)) / (1024.0 * 1024.0);
+    double handshakeMean = handshakes > 0 ? handshakeMicros / handshakes : 0.0;
+    double vectorMean = (mean * latencies.size() - handshakeMicros) / done;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "transport=" << (g_inproc ? "inproc" : !options.unixPath.empty() ? "unix" :
+                                  !options.udpAddress.empty() ? "udp" : "tcp")
+              << " mode=" << options.mode
+              << " type=" << elementTypeName(options.type)
+              << " vectors=" << done
+              << " size=" << options.vectorSize
+              << " batch=" << options.batch << "\n"
+              << "time=" << seconds << "s"
+              << " vectors/s=" << done / seconds
+              << " MB/s=" << megabytes / seconds
+              << " batch_mean_us=" << mean
+              << " batch_p99_us=" << p99
+              << " handshake_mean_us=" << handshakeMean
+              << " vector_mean_us=" << vectorMean << std::endl;
+    if (options.ioStats) {
+        // Средние на вектор по этапам серверной сессии
+        uint64_t vectors = 0;
+        std::vector<IoCounters> stages = g_inproc->ioTotals(vectors);
+        IoCounters total = {};
+        for (size_t i = 0; i < stages.size(); ++i) {
+            total.add(stages[i]);
+            if (!stages[i].empty()) {
+                std::cout << "io_per_vector stage=" << stageName(static_cast<SessionStage>(i)) << " "
+                          << stages[i].format(vectors) << "\n";
+            }
+        }
+        std::cout << "io_per_vector stage=total " << total.format(vectors) << std::endl;
+    }
+    g_inproc.reset();
+    return 0;
+}
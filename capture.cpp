@@ -0,0 +1,170 @@
+#include "capture.h"
+#include "io_stats.h"
+#include <cstring>
+#include <ctime>
+#include <endian.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char CAPTURE_MAGIC[8] = {'V', 'C', 'C', 'A', 'P', 'T', 'R', '1'};
+
+template <typename T>
+static void appendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void encodeCaptureRecord(std::string& out, CaptureRecord kind, uint64_t session, uint64_t timeNs,
+                         const void* data, uint32_t length, bool withData) {
+    appendRaw<uint8_t>(out, static_cast<uint8_t>(kind));
+    appendRaw<uint64_t>(out, htole64(session));
+    appendRaw<uint64_t>(out, htole64(timeNs));
+    appendRaw<uint32_t>(out, htole32(length));
+    if (withData) {
+        out.append(static_cast<const char*>(data), length);
+    }
+}
+
+size_t decodeCaptureRecord(const char* buffer, size_t available, CaptureEntry& entry) {
+    if (available < CAPTURE_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint8_t kind = static_cast<uint8_t>(buffer[0]);
+    if (kind < static_cast<uint8_t>(CaptureRecord::OPEN) || kind > static_cast<uint8_t>(CaptureRecord::CLOSE)) {
+        return 0;
+    }
+    entry.kind = static_cast<CaptureRecord>(kind);
+    memcpy(&entry.session, buffer + 1, sizeof(entry.session));
+    memcpy(&entry.timeNs, buffer + 9, sizeof(entry.timeNs));
+    memcpy(&entry.length, buffer + 17, sizeof(entry.length));
+    entry.session = le64toh(entry.session);
+    entry.timeNs = le64toh(entry.timeNs);
+    entry.length = le32toh(entry.length);
+
+    bool withData = entry.kind == CaptureRecord::LOGIN || entry.kind == CaptureRecord::DATA;
+    if (!withData) {
+        entry.data = nullptr;
+        return CAPTURE_HEADER_SIZE;
+    }
+    if (entry.length > available - CAPTURE_HEADER_SIZE) {
+        return 0;
+    }
+    entry.data = buffer + CAPTURE_HEADER_SIZE;
+    return CAPTURE_HEADER_SIZE + entry.length;
+}
+
+TrafficCapture::TrafficCapture() : fd_(-1) {}
+
+TrafficCapture::~TrafficCapture() {
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+bool TrafficCapture::open(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd_ == -1) {
+        return false;
+    }
+
+    // Блокировка - чтобы два сервера с одним файлом не записали заголовок дважды
+    flock(fd_, LOCK_EX);
+    struct stat info;
+    bool ok = fstat(fd_, &info) == 0 &&
+              (info.st_size > 0 || ::write(fd_, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) ==
+                                       static_cast<ssize_t>(sizeof(CAPTURE_MAGIC)));
+    flock(fd_, LOCK_UN);
+    return ok;
+}
+
+bool TrafficCapture::write(const std::string& records) {
+    ssize_t written = ::write(fd_, records.data(), records.size());
+    IoStats::call(IoCall::WRITE, written);
+    return written == static_cast<ssize_t>(records.size());
+}
+
+uint64_t TrafficCapture::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+CaptureTransport::CaptureTransport(Transport& inner, TrafficCapture& capture, uint64_t session)
+    : inner_(inner), capture_(capture), session_(session), pendingTime_(0) {
+    record(CaptureRecord::OPEN, nullptr, 0, false);
+}
+
+void CaptureTransport::flushLocked(std::string& out) {
+    if (!pending_.empty()) {
+        encodeCaptureRecord(out, CaptureRecord::DATA, session_, pendingTime_,
+                            pending_.data(), static_cast<uint32_t>(pending_.size()), true);
+        pending_.clear();
+    }
+}
+
+void CaptureTransport::record(CaptureRecord kind, const void* data, size_t size, bool withData) {
+    uint64_t time = TrafficCapture::now();
+    std::string out;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushLocked(out);
+        encodeCaptureRecord(out, kind, session_, time, data, static_cast<uint32_t>(size), withData);
+    }
+    capture_.write(out);
+}
+
+void CaptureTransport::received(const void* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) {
+        pendingTime_ = TrafficCapture::now();
+    }
+    pending_.append(static_cast<const char*>(data), size);
+}
+
+bool CaptureTransport::receiveLogin(int connection, std::string& login) {
+    if (!inner_.receiveLogin(connection, login)) {
+        return false;
+    }
+    record(CaptureRecord::LOGIN, login.data(), login.size(), true);
+    return true;
+}
+
+ssize_t CaptureTransport::receiveCredential(int connection, void* buffer, size_t size) {
+    ssize_t bytesReceived = inner_.receiveCredential(connection, buffer, size);
+    if (bytesReceived > 0) {
+        record(CaptureRecord::CREDENTIAL, nullptr, bytesReceived, false);
+    }
+    return bytesReceived;
+}
+
+ssize_t CaptureTransport::receiveSome(int connection, void* buffer, size_t size) {
+    ssize_t bytesReceived = inner_.receiveSome(connection, buffer, size);
+    if (bytesReceived > 0) {
+        received(buffer, bytesReceived);
+    }
+    return bytesReceived;
+}
+
+bool CaptureTransport::receiveData(int connection, void* buffer, size_t size) {
+    if (!inner_.receiveData(connection, buffer, size)) {
+        return false;
+    }
+    received(buffer, size);
+    return true;
+}
+
+bool CaptureTransport::sendData(int connection, const void* data, size_t size) {
+    if (!inner_.sendData(connection, data, size)) {
+        return false;
+    }
+    // Все, что клиент прислал до этого ответа, записывается перед ним
+    record(CaptureRecord::REPLY, nullptr, size, false);
+    return true;
+}
+
+void CaptureTransport::closeClient(int connection) {
+    record(CaptureRecord::CLOSE, nullptr, 0, false);
+    inner_.closeClient(connection);
+}
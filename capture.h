@@ -0,0 +1,92 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "transport.h"
+
+// Запись входящего трафика сессий (server --capture) для воспроизведения
+// утилитой vcalc-replay. Файл: заголовок CAPTURE_MAGIC и записи
+//   [uint8 вид][uint64 сессия][uint64 время, нс][uint32 длина][данные]
+// Время - CLOCK_MONOTONIC, общее для всех процессов сервера. Байты хранятся
+// только у LOGIN и DATA, у остальных записей длина - число байтов без них.
+// Хеш пароля не записывается: vcalc-replay считает его заново по соли
+// сервера и паролю из своей командной строки. Все числа little-endian.
+enum class CaptureRecord : uint8_t {
+    OPEN = 1,        // Начало сессии
+    LOGIN = 2,       // Логин клиента
+    CREDENTIAL = 3,  // Хеш пароля (только длина)
+    DATA = 4,        // Байты клиента, пришедшие между двумя ответами сервера
+    REPLY = 5,       // Ответ сервера (только длина)
+    CLOSE = 6
+};
+
+extern const char CAPTURE_MAGIC[8];
+const size_t CAPTURE_HEADER_SIZE = 21;
+
+struct CaptureEntry {
+    CaptureRecord kind;
+    uint64_t session;
+    uint64_t timeNs;
+    uint32_t length;
+    const char* data;  // Указывает внутрь разобранного буфера; nullptr без байтов
+};
+
+void encodeCaptureRecord(std::string& out, CaptureRecord kind, uint64_t session, uint64_t timeNs,
+                         const void* data, uint32_t length, bool withData);
+
+// Возвращает длину записи или 0, если запись неполная или повреждена
+size_t decodeCaptureRecord(const char* buffer, size_t available, CaptureEntry& entry);
+
+// Файл записи трафика. Каждая запись уходит одним write() в файл,
+// открытый с O_APPEND, поэтому его делят потоки и процессы после fork().
+class TrafficCapture {
+private:
+    int fd_;
+
+public:
+    TrafficCapture();
+    ~TrafficCapture();
+
+    TrafficCapture(const TrafficCapture&) = delete;
+    TrafficCapture& operator=(const TrafficCapture&) = delete;
+
+    // Дописывает в существующий файл, заголовок - только в пустой
+    bool open(const std::string& path);
+    bool write(const std::string& records);
+
+    static uint64_t now();
+};
+
+// Транспорт сессии, который пишет принятые байты в TrafficCapture.
+// Байты, прочитанные подряд до ответа сервера, становятся одной записью DATA
+// со временем прихода первого из них.
+class CaptureTransport : public Transport {
+private:
+    Transport& inner_;
+    TrafficCapture& capture_;
+    uint64_t session_;
+    // Читающий поток и задачи пула (режим с номерами запросов) работают одновременно
+    std::mutex mutex_;
+    std::string pending_;
+    uint64_t pendingTime_;
+
+public:
+    CaptureTransport(Transport& inner, TrafficCapture& capture, uint64_t session);
+
+    bool receiveLogin(int connection, std::string& login) override;
+    ssize_t receiveCredential(int connection, void* buffer, size_t size) override;
+    ssize_t receiveSome(int connection, void* buffer, size_t size) override;
+    bool receiveData(int connection, void* buffer, size_t size) override;
+    bool sendData(int connection, const void* data, size_t size) override;
+    void closeClient(int connection) override;
+
+private:
+    void received(const void* data, size_t size);
+    void record(CaptureRecord kind, const void* data, size_t size, bool withData);
+    void flushLocked(std::string& out);
+};
+
+#endif // CAPTURE_H
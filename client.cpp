@@ -0,0 +1,643 @@
+#include "client.h"
+#include "authenticator.h"
+#include "protocol.h"
+#include "float_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <endian.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <ctime>
+#include <random>
+
+// Появилась в Linux 4.11, в старых заголовках libc ее нет
+#ifndef TCP_FASTOPEN_CONNECT
+#define TCP_FASTOPEN_CONNECT 30
+#endif
+
+VcalcClient::VcalcClient()
+    : socket_(-1), shmActive_(false), framedActive_(false), framedFlags_(0),
+      udpRequestId_(std::random_device()()), timeoutMs_(0), noDelay_(false), fastOpen_(false) {}
+
+VcalcClient::~VcalcClient() {
+    disconnect();
+}
+
+bool VcalcClient::fail(const std::string& message) {
+    lastError_ = message;
+    return false;
+}
+
+void VcalcClient::applyTimeout() {
+    if (timeoutMs_ <= 0 || socket_ == -1) {
+        return;
+    }
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs_ / 1000;
+    timeout.tv_usec = (timeoutMs_ % 1000) * 1000;
+    setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    // SO_SNDTIMEO ограничивает и connect()
+    setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool VcalcClient::connectTcp(const std::string& host, uint16_t port) {
+    disconnect();
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
+        return fail("Cannot resolve host " + host);
+    }
+
+    socket_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    applyTimeout();
+    int opt = 1;
+    if (socket_ != -1 && noDelay_) {
+        setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    }
+    // connect() завершается сразу, а SYN уходит вместе с первым send() (логином)
+    if (socket_ != -1 && fastOpen_) {
+        setsockopt(socket_, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &opt, sizeof(opt));
+    }
+    if (socket_ == -1 || ::connect(socket_, result->ai_addr, result->ai_addrlen) < 0) {
+        std::string error = strerror(errno);
+        freeaddrinfo(result);
+        disconnect();
+        return fail("Cannot connect to " + host + ":" + std::to_string(port) + ": " + error);
+    }
+
+    freeaddrinfo(result);
+    return true;
+}
+
+bool VcalcClient::connectUnix(const std::string& path) {
+    disconnect();
+
+    struct sockaddr_un addr;
+    if (path.length() >= sizeof(addr.sun_path)) {
+        return fail("Unix socket path is too long: " + path);
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    socket_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    applyTimeout();
+    if (socket_ == -1 || ::connect(socket_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::string error = strerror(errno);
+        disconnect();
+        return fail("Cannot connect to " + path + ": " + error);
+    }
+    return true;
+}
+
+void VcalcClient::adoptSocket(int socket) {
+    disconnect();
+    socket_ = socket;
+    applyTimeout();
+}
+
+void VcalcClient::disconnect() {
+    closeSharedMemory();
+    closeFramed();
+    if (socket_ != -1) {
+        close(socket_);
+        socket_ = -1;
+    }
+}
+
+bool VcalcClient::sendAll(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    size_t total = 0;
+    while (total < size) {
+        ssize_t sent = send(socket_, bytes + total, size - total, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return fail("Send failed: " + std::string(strerror(errno)));
+        }
+        total += sent;
+    }
+    return true;
+}
+
+bool VcalcClient::receiveAll(void* buffer, size_t size) {
+    char* bytes = static_cast<char*>(buffer);
+    size_t total = 0;
+    while (total < size) {
+        ssize_t received = recv(socket_, bytes + total, size - total, 0);
+        if (received <= 0) {
+            return fail(received == 0 ? "Server closed connection"
+                                      : "Receive failed: " + std::string(strerror(errno)));
+        }
+        total += received;
+    }
+    return true;
+}
+
+bool VcalcClient::login(const std::string& user, const std::string& password) {
+    if (!sendAll(user.data(), user.size())) {
+        return false;
+    }
+
+    // Вместо соли сервер может сразу ответить "ERR" и закрыть соединение
+    char salt[16];
+    size_t received = 0;
+    while (received < sizeof(salt)) {
+        ssize_t n = recv(socket_, salt + received, sizeof(salt) - received, 0);
+        if (n <= 0) {
+            break;
+        }
+        received += n;
+    }
+    if (received != sizeof(salt)) {
+        return fail("Authentication rejected for user " + user);
+    }
+
+    std::string hash = Authenticator::calculateHash(std::string(salt, sizeof(salt)), password);
+    if (!sendAll(hash.data(), hash.size())) {
+        return false;
+    }
+
+    char reply[2];
+    if (!receiveAll(reply, sizeof(reply)) || memcmp(reply, "OK", 2) != 0) {
+        return fail("Authentication failed for user " + user);
+    }
+    return true;
+}
+
+bool VcalcClient::computeProducts(const std::vector<std::vector<float>>& vectors,
+                                  std::vector<float>& results) {
+    if (vectors.empty() || vectors.size() > MAX_VECTORS_PER_SESSION) {
+        return fail("Classic protocol accepts 1-" + std::to_string(MAX_VECTORS_PER_SESSION) + " vectors");
+    }
+
+    uint32_t count = htole32(static_cast<uint32_t>(vectors.size()));
+    if (!sendAll(&count, sizeof(count))) {
+        return false;
+    }
+
+    results.assign(vectors.size(), 0.0f);
+    std::vector<uint32_t> frame;
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        const auto& vector = vectors[i];
+        frame.resize(vector.size() + 1);
+        frame[0] = htole32(static_cast<uint32_t>(vector.size()));
+        for (size_t j = 0; j < vector.size(); ++j) {
+            uint32_t bits;
+            memcpy(&bits, &vector[j], sizeof(bits));
+            frame[j + 1] = htole32(bits);
+        }
+
+        uint32_t result;
+        if (!sendAll(frame.data(), frame.size() * sizeof(uint32_t)) ||
+            !receiveAll(&result, sizeof(result))) {
+            return false;
+        }
+
+        result = le32toh(result);
+        memcpy(&results[i], &result, sizeof(result));
+    }
+    return true;
+}
+
+bool VcalcClient::computeProductsTagged(const std::vector<std::vector<float>>& vectors,
+                                        std::vector<float>& results) {
+    uint32_t mode = htole32(PROTOCOL_MODE_TAGGED);
+    if (!sendAll(&mode, sizeof(mode))) {
+        return false;
+    }
+
+    // Весь поток запросов с завершающим нулевым размером
+    std::vector<uint32_t> stream;
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        if (vectors[i].empty() || vectors[i].size() > MAX_TAGGED_VECTOR_SIZE) {
+            return fail("Tagged vector size must be 1-" + std::to_string(MAX_TAGGED_VECTOR_SIZE));
+        }
+        stream.push_back(htole32(static_cast<uint32_t>(i)));
+        stream.push_back(htole32(static_cast<uint32_t>(vectors[i].size())));
+        for (float value : vectors[i]) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            stream.push_back(htole32(bits));
+        }
+    }
+    stream.push_back(0);
+    stream.push_back(0);
+
+    // Запись и чтение чередуются, чтобы сервер не заблокировался на отправке ответов
+    const char* output = reinterpret_cast<const char*>(stream.data());
+    size_t outputSize = stream.size() * sizeof(uint32_t);
+    size_t written = 0;
+
+    results.assign(vectors.size(), 0.0f);
+    uint32_t reply[2];
+    size_t replyBytes = 0;
+    size_t completed = 0;
+
+    while (completed < vectors.size()) {
+        struct pollfd pfd;
+        pfd.fd = socket_;
+        pfd.events = POLLIN | (written < outputSize ? POLLOUT : 0);
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 10000) <= 0) {
+            return fail("Timed out in tagged session");
+        }
+
+        if ((pfd.revents & POLLOUT) && written < outputSize) {
+            ssize_t sent = send(socket_, output + written, outputSize - written, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                return fail("Send failed: " + std::string(strerror(errno)));
+            }
+            if (sent > 0) {
+                written += sent;
+            }
+        }
+
+        if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t received = recv(socket_, reinterpret_cast<char*>(reply) + replyBytes,
+                                    sizeof(reply) - replyBytes, MSG_DONTWAIT);
+            if (received == 0) {
+                return fail("Server closed connection");
+            }
+            if (received < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    continue;
+                }
+                return fail("Receive failed: " + std::string(strerror(errno)));
+            }
+            replyBytes += received;
+            if (replyBytes == sizeof(reply)) {
+                uint32_t requestId = le32toh(reply[0]);
+                uint32_t bits = le32toh(reply[1]);
+                if (requestId < results.size()) {
+                    memcpy(&results[requestId], &bits, sizeof(bits));
+                }
+                replyBytes = 0;
+                completed++;
+            }
+        }
+    }
+    return true;
+}
+
+bool VcalcClient::openFramed() {
+    uint32_t mode = htole32(PROTOCOL_MODE_FRAMED);
+    uint32_t hello[2];
+    if (!sendAll(&mode, sizeof(mode)) || !receiveAll(hello, sizeof(hello))) {
+        return false;
+    }
+    if (le32toh(hello[0]) != FRAMED_PROTOCOL_VERSION) {
+        return fail("Server does not support protocol v2");
+    }
+    framedFlags_ = le32toh(hello[1]);
+    framedActive_ = true;
+    return true;
+}
+
+bool VcalcClient::computeProductsFramed(const std::vector<std::vector<float>>& vectors,
+                                        std::vector<float>& results, bool compress) {
+    std::vector<uint32_t> sizes(vectors.size());
+    size_t totalElements = 0;
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        sizes[i] = static_cast<uint32_t>(vectors[i].size());
+        totalElements += vectors[i].size();
+    }
+
+    std::vector<uint8_t> raw(totalElements * sizeof(float));
+    uint8_t* out = raw.data();
+    for (const auto& vector : vectors) {
+        for (float value : vector) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            bits = htole32(bits);
+            memcpy(out, &bits, sizeof(bits));
+            out += sizeof(bits);
+        }
+    }
+
+    std::vector<uint8_t> reply;
+    if (!computeProductsTyped(ElementType::FLOAT32, sizes, raw, reply, compress)) {
+        return false;
+    }
+
+    results.assign(vectors.size(), 0.0f);
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        uint32_t bits;
+        memcpy(&bits, reply.data() + i * sizeof(bits), sizeof(bits));
+        bits = le32toh(bits);
+        memcpy(&results[i], &bits, sizeof(bits));
+    }
+    return true;
+}
+
+bool VcalcClient::computeProductsTyped(ElementType type, const std::vector<uint32_t>& sizes,
+                                       const std::vector<uint8_t>& data, std::vector<uint8_t>& results,
+                                       bool compress, std::vector<bool>* overflowed) {
+    if (!framedActive_) {
+        return fail("Protocol v2 session is not open");
+    }
+    if (sizes.empty() || sizes.size() > MAX_FRAMED_VECTORS) {
+        return fail("Protocol v2 batch must contain 1-" + std::to_string(MAX_FRAMED_VECTORS) + " vectors");
+    }
+    if (compress && !(framedFlags_ & FRAMED_FLAG_LZ)) {
+        return fail("Server does not support compressed batches");
+    }
+    if (type >= ElementType::TYPE_COUNT ||
+        (type != ElementType::FLOAT32 && !(framedFlags_ & FRAMED_FLAG_TYPED))) {
+        return fail(std::string("Server does not support element type ") + elementTypeName(type));
+    }
+    if (overflowed && !(framedFlags_ & FRAMED_FLAG_STATUS)) {
+        return fail("Server does not report overflow status");
+    }
+
+    // Заголовок и размеры векторов, затем данные одним блоком
+    std::vector<uint32_t> header(3 + sizes.size());
+    size_t totalElements = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        if (sizes[i] == 0 || sizes[i] > MAX_TAGGED_VECTOR_SIZE) {
+            return fail("Vector size must be 1-" + std::to_string(MAX_TAGGED_VECTOR_SIZE));
+        }
+        header[3 + i] = htole32(sizes[i]);
+        totalElements += sizes[i];
+    }
+    if (totalElements > MAX_FRAMED_ELEMENTS) {
+        return fail("Protocol v2 batch exceeds " + std::to_string(MAX_FRAMED_ELEMENTS) + " elements");
+    }
+    size_t width = elementWidth(type);
+    if (data.size() != totalElements * width) {
+        return fail("Batch data does not match vector sizes");
+    }
+
+    std::vector<uint8_t> packed;
+    if (compress) {
+        compressElements(data.data(), totalElements, width, packed);
+    }
+    const std::vector<uint8_t>& payload = compress ? packed : data;
+
+    uint32_t flags = static_cast<uint32_t>(type) << FRAMED_TYPE_SHIFT;
+    if (compress) {
+        flags |= FRAMED_FLAG_LZ;
+    }
+    if (overflowed) {
+        flags |= FRAMED_FLAG_STATUS;
+    }
+    header[0] = htole32(static_cast<uint32_t>(sizes.size()));
+    header[1] = htole32(flags);
+    header[2] = htole32(static_cast<uint32_t>(payload.size()));
+    // Одна запись на пакет: раздельные send() заголовка и данных
+    // упираются в алгоритм Нейгла и отложенное подтверждение
+    std::vector<uint8_t> message(header.size() * sizeof(uint32_t) + payload.size());
+    memcpy(message.data(), header.data(), header.size() * sizeof(uint32_t));
+    memcpy(message.data() + header.size() * sizeof(uint32_t), payload.data(), payload.size());
+    if (!sendAll(message.data(), message.size())) {
+        return false;
+    }
+
+    uint32_t count;
+    if (!receiveAll(&count, sizeof(count))) {
+        return false;
+    }
+    if (le32toh(count) != sizes.size()) {
+        return fail("Unexpected number of results in protocol v2 reply");
+    }
+    if (overflowed) {
+        std::vector<uint32_t> mask(overflowMaskBytes(static_cast<uint32_t>(sizes.size())) / sizeof(uint32_t));
+        if (!receiveAll(mask.data(), mask.size() * sizeof(uint32_t))) {
+            return false;
+        }
+        overflowed->assign(sizes.size(), false);
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            (*overflowed)[i] = (le32toh(mask[i / 32]) >> (i % 32)) & 1;
+        }
+    }
+    results.resize(sizes.size() * resultWidth(type));
+    return receiveAll(results.data(), results.size());
+}
+
+void VcalcClient::closeFramed() {
+    if (!framedActive_) {
+        return;
+    }
+    uint32_t end[3] = {0, 0, 0};
+    sendAll(end, sizeof(end));
+    framedActive_ = false;
+}
+
+bool VcalcClient::openSharedMemory() {
+    uint32_t mode = htole32(PROTOCOL_MODE_SHM);
+    if (!sendAll(&mode, sizeof(mode))) {
+        return false;
+    }
+
+    uint32_t capacity = 0;
+    int fds[3] = {-1, -1, -1};
+
+    struct iovec iov;
+    iov.iov_base = &capacity;
+    iov.iov_len = sizeof(capacity);
+
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received = recvmsg(socket_, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    if (received != sizeof(capacity)) {
+        return fail("Failed to receive shared memory setup");
+    }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (le32toh(capacity) == 0 || cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        return fail("Server refused shared memory mode");
+    }
+
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    if (!shm_.attach(fds[0], fds[1], fds[2])) {
+        return fail("Failed to map shared memory rings");
+    }
+
+    shmActive_ = true;
+    return true;
+}
+
+bool VcalcClient::computeProductsShm(const std::vector<std::vector<float>>& vectors,
+                                     std::vector<float>& results) {
+    if (!shmActive_) {
+        return fail("Shared memory mode is not active");
+    }
+
+    ShmRing requests = shm_.requestRing();
+    ShmRing responses = shm_.responseRing();
+    const int timeoutMs = 10000;
+
+    for (const auto& vector : vectors) {
+        if (vector.empty() || vector.size() > MAX_VECTOR_SIZE) {
+            return fail("Vector size must be 1-" + std::to_string(MAX_VECTOR_SIZE));
+        }
+    }
+
+    results.assign(vectors.size(), 0.0f);
+    size_t sent = 0;
+    size_t completed = 0;
+
+    while (completed < vectors.size()) {
+        // Пишем запросы прямо в кольцо, пока есть место
+        while (sent < vectors.size()) {
+            uint32_t payloadSize = static_cast<uint32_t>(vectors[sent].size() * sizeof(float));
+            void* slot = requests.reserve(payloadSize);
+            if (slot == nullptr) {
+                break;
+            }
+            memcpy(slot, vectors[sent].data(), payloadSize);
+            requests.publish(payloadSize, static_cast<uint32_t>(sent));
+            sent++;
+        }
+
+        uint32_t payloadSize;
+        uint32_t tag;
+        const void* payload = responses.front(payloadSize, tag);
+        if (payload == nullptr) {
+            if (!responses.waitReadable(socket_, timeoutMs)) {
+                return fail("Timed out waiting for shared memory results");
+            }
+            continue;
+        }
+
+        if (tag < results.size() && payloadSize == sizeof(float)) {
+            memcpy(&results[tag], payload, sizeof(float));
+        }
+        responses.pop();
+        completed++;
+    }
+    return true;
+}
+
+void VcalcClient::closeSharedMemory() {
+    if (!shmActive_) {
+        return;
+    }
+
+    ShmRing requests = shm_.requestRing();
+    if (requests.waitWritable(0, socket_, 1000) && requests.reserve(0) != nullptr) {
+        requests.publish(0, 0);
+    }
+    shm_.release();
+    shmActive_ = false;
+}
+
+bool VcalcClient::computeProductsUdp(const std::string& host, uint16_t port,
+                                     const std::string& user, const std::string& password,
+                                     const std::vector<std::vector<float>>& vectors,
+                                     std::vector<float>& results) {
+    if (user.size() > 255) {
+        return fail("Login is too long for UDP mode");
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo* address = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &address) != 0) {
+        return fail("Cannot resolve host " + host);
+    }
+
+    int udpSocket = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (udpSocket == -1 || ::connect(udpSocket, address->ai_addr, address->ai_addrlen) < 0) {
+        freeaddrinfo(address);
+        if (udpSocket != -1) {
+            close(udpSocket);
+        }
+        return fail("Cannot open UDP socket: " + std::string(strerror(errno)));
+    }
+    freeaddrinfo(address);
+
+    uint64_t timestamp = static_cast<uint64_t>(time(nullptr));
+
+    // Логин и метка времени одинаковы для всех датаграмм сессии
+    std::string header;
+    header.push_back(static_cast<char>(user.size()));
+    header += user;
+    uint64_t timestampLe = htole64(timestamp);
+    header.append(reinterpret_cast<const char*>(&timestampLe), sizeof(timestampLe));
+
+    // Номера запросов не повторяются между вызовами: сервер принимает
+    // (метку времени, номер) только один раз
+    uint32_t firstId = udpRequestId_;
+    udpRequestId_ += static_cast<uint32_t>(vectors.size());
+
+    results.assign(vectors.size(), 0.0f);
+    const size_t window = 64;
+    std::string datagram;
+    std::string body;
+    bool ok = true;
+
+    for (size_t first = 0; first < vectors.size() && ok; first += window) {
+        size_t last = std::min(vectors.size(), first + window);
+
+        for (size_t i = first; i < last; ++i) {
+            uint32_t fields[2] = {htole32(firstId + static_cast<uint32_t>(i)),
+                                  htole32(static_cast<uint32_t>(vectors[i].size()))};
+            body.assign(reinterpret_cast<const char*>(fields), sizeof(fields));
+            for (float value : vectors[i]) {
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                bits = htole32(bits);
+                body.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+            }
+            datagram = header;
+            datagram += Authenticator::calculateToken(password, timestamp, body.data(), body.size());
+            datagram += body;
+            if (send(udpSocket, datagram.data(), datagram.size(), 0) < 0) {
+                ok = fail("UDP send failed: " + std::string(strerror(errno)));
+                break;
+            }
+        }
+
+        for (size_t received = first; ok && received < last; ++received) {
+            struct pollfd pfd;
+            pfd.fd = udpSocket;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, 1000) <= 0) {
+                ok = fail("Timed out waiting for UDP response");
+                break;
+            }
+
+            uint32_t response[3];
+            if (recv(udpSocket, response, sizeof(response), 0) != sizeof(response)) {
+                ok = fail("Malformed UDP response");
+                break;
+            }
+
+            uint32_t requestId = le32toh(response[0]) - firstId;
+            uint32_t status = le32toh(response[1]);
+            uint32_t bits = le32toh(response[2]);
+            if (status != UDP_STATUS_OK || requestId >= results.size()) {
+                ok = fail("UDP request rejected with status " + std::to_string(status));
+                break;
+            }
+            memcpy(&results[requestId], &bits, sizeof(bits));
+        }
+    }
+
+    close(udpSocket);
+    return ok;
+}
@@ -0,0 +1,88 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "protocol.h"
+#include "shm_ring.h"
+
+// Клиент протокола векторного сервера. Используется инструментами
+// (бенчмарк), работает без логгера и сообщает об ошибках через lastError().
+class VcalcClient {
+private:
+    int socket_;
+    ShmChannel shm_;
+    bool shmActive_;
+    bool framedActive_;
+    uint32_t framedFlags_;  // Флаги, которые поддерживает сервер (протокол v2)
+    uint32_t udpRequestId_;  // Следующий номер UDP-запроса; сервер отклоняет повторы
+    int timeoutMs_;
+    bool noDelay_;
+    bool fastOpen_;
+    std::string lastError_;
+
+public:
+    VcalcClient();
+    ~VcalcClient();
+
+    VcalcClient(const VcalcClient&) = delete;
+    VcalcClient& operator=(const VcalcClient&) = delete;
+
+    // Таймаут подключения и каждой операции чтения/записи (0 - без таймаута);
+    // действует на следующие connectTcp/connectUnix
+    void setTimeout(int milliseconds) { timeoutMs_ = milliseconds; }
+
+    // TCP_NODELAY и TCP Fast Open (логин уходит вместе с SYN) для connectTcp
+    void setTcpOptions(bool noDelay, bool fastOpen) { noDelay_ = noDelay; fastOpen_ = fastOpen; }
+
+    bool connectTcp(const std::string& host, uint16_t port);
+    bool connectUnix(const std::string& path);
+    // Работа по уже открытому сокету (например, из socketpair()); клиент становится его владельцем
+    void adoptSocket(int socket);
+    void disconnect();
+
+    bool login(const std::string& user, const std::string& password);
+
+    // Классический протокол: количество векторов, затем каждый вектор
+    bool computeProducts(const std::vector<std::vector<float>>& vectors, std::vector<float>& results);
+
+    // Режим с номерами запросов: все векторы отправляются сразу,
+    // ответы приходят в порядке готовности и раскладываются по номерам
+    bool computeProductsTagged(const std::vector<std::vector<float>>& vectors, std::vector<float>& results);
+
+    // Протокол v2: пакеты любого размера с общим заголовком в одной сессии,
+    // compress - сжатие данных пакета (перестановка байтов + LZ)
+    bool openFramed();
+    bool computeProductsFramed(const std::vector<std::vector<float>>& vectors, std::vector<float>& results,
+                               bool compress);
+    // Пакет элементов типа type: data - все векторы подряд в little-endian,
+    // results - sizes.size() произведений по resultWidth(type) байт в little-endian;
+    // overflowed (если задан) получает признак переполнения каждого произведения
+    bool computeProductsTyped(ElementType type, const std::vector<uint32_t>& sizes,
+                              const std::vector<uint8_t>& data, std::vector<uint8_t>& results, bool compress,
+                              std::vector<bool>* overflowed = nullptr);
+    void closeFramed();
+
+    // Режим колец в разделяемой памяти (только после login() по Unix-сокету)
+    bool openSharedMemory();
+    bool computeProductsShm(const std::vector<std::vector<float>>& vectors, std::vector<float>& results);
+    void closeSharedMemory();
+
+    // UDP-режим: каждый вектор отправляется отдельной датаграммой с токеном
+    bool computeProductsUdp(const std::string& host, uint16_t port,
+                            const std::string& user, const std::string& password,
+                            const std::vector<std::vector<float>>& vectors, std::vector<float>& results);
+
+    bool sendAll(const void* data, size_t size);
+    bool receiveAll(void* buffer, size_t size);
+
+    int socket() const { return socket_; }
+    const std::string& lastError() const { return lastError_; }
+
+private:
+    bool fail(const std::string& message);
+    void applyTimeout();
+};
+
+#endif // CLIENT_H
@@ -0,0 +1,198 @@
+#include "client_scheduler.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+// Клиент без запросов дольше этого времени удаляется из учета
+static const auto CLIENT_IDLE_EXPIRY = std::chrono::minutes(10);
+
+TokenBucket::TokenBucket(double rate, double burst)
+    : rate_(rate),
+      burst_(std::max(burst, 1.0)),
+      tokens_(std::max(burst, 1.0)),
+      updated_(std::chrono::steady_clock::now()) {}
+
+void TokenBucket::refill(std::chrono::steady_clock::time_point now) {
+    if (unlimited()) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - updated_).count();
+    tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+    updated_ = now;
+}
+
+bool TokenBucket::tryConsume(double amount, std::chrono::steady_clock::time_point now) {
+    if (unlimited()) {
+        return true;
+    }
+    refill(now);
+    // Запрос больше емкости ведра пропускается при полном ведре,
+    // иначе он не прошел бы никогда
+    double needed = std::min(amount, burst_);
+    if (tokens_ < needed) {
+        return false;
+    }
+    tokens_ -= amount;
+    return true;
+}
+
+std::chrono::microseconds TokenBucket::waitTime(double amount) const {
+    if (unlimited()) {
+        return std::chrono::microseconds(0);
+    }
+    double needed = std::min(amount, burst_) - tokens_;
+    if (needed <= 0.0) {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::microseconds(static_cast<int64_t>(needed / rate_ * 1e6) + 1);
+}
+
+ClientScheduler::ClientState::ClientState(const ClientLimits& limits, double clientWeight)
+    : vectorBucket(limits.vectorsPerSecond, limits.vectorsPerSecond * limits.burstSeconds),
+      elementBucket(limits.elementsPerSecond, limits.elementsPerSecond * limits.burstSeconds),
+      weight(clientWeight),
+      lastFinishTag(0.0),
+      stats(),
+      lastSeen(std::chrono::steady_clock::now()) {}
+
+ClientScheduler::ClientScheduler(const ClientLimits& limits,
+                                 const std::unordered_map<std::string, double>& weights)
+    : limits_(limits), weights_(weights), virtualTime_(0.0) {}
+
+ClientScheduler::ClientState& ClientScheduler::stateFor(const std::string& key) {
+    auto it = clients_.find(key);
+    if (it == clients_.end()) {
+        auto weight = weights_.find(key);
+        double clientWeight = weight != weights_.end() ? weight->second : 1.0;
+        it = clients_.emplace(key, ClientState(limits_, clientWeight)).first;
+        it->second.stats.key = key;
+        it->second.stats.weight = clientWeight;
+    }
+    return it->second;
+}
+
+void ClientScheduler::admit(const std::string& key, size_t elements) {
+    bool throttled = false;
+    auto waitStart = std::chrono::steady_clock::now();
+
+    while (true) {
+        std::chrono::microseconds wait;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ClientState& state = stateFor(key);
+            auto now = std::chrono::steady_clock::now();
+            state.lastSeen = now;
+
+            state.vectorBucket.refill(now);
+            state.elementBucket.refill(now);
+            wait = std::max(state.vectorBucket.waitTime(1.0),
+                            state.elementBucket.waitTime(static_cast<double>(elements)));
+
+            if (wait.count() == 0) {
+                state.vectorBucket.tryConsume(1.0, now);
+                state.elementBucket.tryConsume(static_cast<double>(elements), now);
+                state.stats.vectors++;
+                state.stats.elements += elements;
+                if (throttled) {
+                    state.stats.throttled++;
+                    state.stats.throttledMicros += std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - waitStart).count();
+                }
+                return;
+            }
+        }
+
+        // Ждем вне блокировки: остальные клиенты не должны стоять за этим
+        throttled = true;
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+bool ClientScheduler::tryAdmit(const std::string& key, size_t elements) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClientState& state = stateFor(key);
+    auto now = std::chrono::steady_clock::now();
+    state.lastSeen = now;
+
+    state.vectorBucket.refill(now);
+    state.elementBucket.refill(now);
+    if (state.vectorBucket.waitTime(1.0).count() != 0 ||
+        state.elementBucket.waitTime(static_cast<double>(elements)).count() != 0) {
+        state.stats.rejected++;
+        return false;
+    }
+
+    state.vectorBucket.tryConsume(1.0, now);
+    state.elementBucket.tryConsume(static_cast<double>(elements), now);
+    state.stats.vectors++;
+    state.stats.elements += elements;
+    return true;
+}
+
+void ClientScheduler::submit(WorkerPool& pool, const std::string& key, size_t cost,
+                             std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ClientState& state = stateFor(key);
+
+        // Виртуальное время окончания: клиент с большим весом продвигается медленнее
+        double start = std::max(virtualTime_, state.lastFinishTag);
+        double finish = start + static_cast<double>(std::max<size_t>(cost, 1)) / state.weight;
+        state.lastFinishTag = finish;
+        state.queue.push_back(QueuedTask{start, finish, std::move(task)});
+        state.stats.queued = state.queue.size();
+    }
+
+    // Пул выполняет не саму задачу, а выбор следующей по WFQ:
+    // на каждую поставленную задачу приходится ровно один такой вызов
+    pool.submit([this] { runNext(); });
+}
+
+void ClientScheduler::runNext() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ClientState* selected = nullptr;
+        double bestTag = std::numeric_limits<double>::max();
+
+        for (auto& entry : clients_) {
+            ClientState& state = entry.second;
+            if (!state.queue.empty() && state.queue.front().finishTag < bestTag) {
+                bestTag = state.queue.front().finishTag;
+                selected = &state;
+            }
+        }
+
+        if (selected == nullptr) {
+            return;
+        }
+
+        // Виртуальное время - начало выбранной задачи, а не ее окончание:
+        // иначе вернувшийся после простоя клиент получал бы метки впереди
+        // занятых клиентов и терял свою долю
+        virtualTime_ = std::max(virtualTime_, selected->queue.front().startTag);
+        task = std::move(selected->queue.front().task);
+        selected->queue.pop_front();
+        selected->stats.queued = selected->queue.size();
+    }
+    task();
+}
+
+std::vector<ClientScheduler::ClientStats> ClientScheduler::snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    std::vector<ClientStats> result;
+
+    for (auto it = clients_.begin(); it != clients_.end();) {
+        if (it->second.queue.empty() && now - it->second.lastSeen > CLIENT_IDLE_EXPIRY) {
+            it = clients_.erase(it);
+            continue;
+        }
+        result.push_back(it->second.stats);
+        ++it;
+    }
+
+    std::sort(result.begin(), result.end(),
+              [](const ClientStats& a, const ClientStats& b) { return a.vectors > b.vectors; });
+    return result;
+}
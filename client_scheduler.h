@@ -0,0 +1,98 @@
+#ifndef CLIENT_SCHEDULER_H
+#define CLIENT_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "worker_pool.h"
+
+// Ведро токенов: rate токенов в секунду, не больше burst в запасе.
+// Нулевая скорость означает отсутствие ограничения.
+class TokenBucket {
+private:
+    double rate_;
+    double burst_;
+    double tokens_;
+    std::chrono::steady_clock::time_point updated_;
+
+public:
+    TokenBucket(double rate, double burst);
+
+    bool unlimited() const { return rate_ <= 0.0; }
+    void refill(std::chrono::steady_clock::time_point now);
+    bool tryConsume(double amount, std::chrono::steady_clock::time_point now);
+    // Сколько ждать, пока накопится amount токенов
+    std::chrono::microseconds waitTime(double amount) const;
+};
+
+struct ClientLimits {
+    double vectorsPerSecond = 0.0;
+    double elementsPerSecond = 0.0;
+    double burstSeconds = 1.0;
+};
+
+// Учет по клиентам: ограничение скорости и взвешенная справедливая
+// очередь (WFQ) перед пулом вычислений. Ключ клиента - IP или логин.
+class ClientScheduler {
+public:
+    struct ClientStats {
+        std::string key;
+        double weight;
+        uint64_t vectors;
+        uint64_t elements;
+        uint64_t throttled;
+        uint64_t rejected;
+        uint64_t throttledMicros;
+        size_t queued;
+    };
+
+private:
+    struct QueuedTask {
+        double startTag;
+        double finishTag;
+        std::function<void()> task;
+    };
+
+    struct ClientState {
+        TokenBucket vectorBucket;
+        TokenBucket elementBucket;
+        double weight;
+        double lastFinishTag;
+        std::deque<QueuedTask> queue;
+        ClientStats stats;
+        std::chrono::steady_clock::time_point lastSeen;
+
+        ClientState(const ClientLimits& limits, double clientWeight);
+    };
+
+    ClientLimits limits_;
+    std::unordered_map<std::string, double> weights_;
+    std::unordered_map<std::string, ClientState> clients_;
+    double virtualTime_;  // Начальная метка последней выбранной задачи
+    std::mutex mutex_;
+
+public:
+    ClientScheduler(const ClientLimits& limits, const std::unordered_map<std::string, double>& weights);
+
+    // Блокирует вызывающий поток, пока у клиента не хватит токенов
+    void admit(const std::string& key, size_t elements);
+    // Неблокирующий вариант для датаграмм: false - запрос нужно отклонить
+    bool tryAdmit(const std::string& key, size_t elements);
+
+    // Ставит задачу в очередь клиента; пул берет задачи в порядке WFQ
+    void submit(WorkerPool& pool, const std::string& key, size_t cost, std::function<void()> task);
+
+    // Статистика по клиентам; давно неактивные клиенты при этом забываются
+    std::vector<ClientStats> snapshot();
+
+private:
+    ClientState& stateFor(const std::string& key);
+    void runNext();
+};
+
+#endif // CLIENT_SCHEDULER_H
@@ -13,6 +13,53 @@ bool ServerConfig::validate() const {
         throw ConfigException("Log file path cannot be empty");
     }
     
+    if (!tcpEnabled && unixSocket.empty()) {
+        throw ConfigException("--no-tcp requires --unix-socket");
+    }
+    
+    if (unixSocket.length() >= 108) {
+        throw ConfigException("Unix socket path must be shorter than 108 characters");
+    }
+    
+    if (adminSocket.length() >= 108) {
+        throw ConfigException("Admin socket path must be shorter than 108 characters");
+    }
+    
+    if (upgradeSocket.empty() || upgradeSocket.length() >= 108) {
+        throw ConfigException("Upgrade socket path must be 1-107 characters long");
+    }
+    
+    if (processes > 1 && !adminSocket.empty()) {
+        throw ConfigException("--admin-socket is not supported with --processes");
+    }
+    
+    if (processes > 1 && (logMaxSize > 0 || logMaxAge > 0)) {
+        throw ConfigException("Log rotation is not supported with --processes");
+    }
+    
+    // Записи копятся в буфере каждого процесса и сбрасываются в общий файл
+    // кусками произвольной длины, которые vcalc-logdump уже не разберет
+    if (processes > 1 && binaryLog) {
+        throw ConfigException("--log-format binary is not supported with --processes");
+    }
+    
+    if (!proxyBackends.empty() && processes > 1) {
+        throw ConfigException("--proxy is not supported with --processes");
+    }
+    
+    if (lazyInit && (processes > 1 || !proxyBackends.empty())) {
+        throw ConfigException("--lazy-init is not supported with --processes or --proxy");
+    }
+    
+    if (!captureFile.empty() && !proxyBackends.empty()) {
+        throw ConfigException("--capture is not supported with --proxy");
+    }
+    
+    // SIGPROF и таймер не переживают fork в рабочие процессы
+    if (!profileFile.empty() && processes > 1) {
+        throw ConfigException("--profile is not supported with --processes");
+    }
+    
     if (port < 1024) {
         throw ConfigException("Port must be in range 1024-65535");
     }
@@ -70,6 +117,280 @@ bool Config::parseCommandLine(int argc, char* argv[]) {
                 throw ConfigException("Missing value for --port option");
             }
         }
+        else if (arg == "-u" || arg == "--unix-socket") {
+            if (i + 1 < argc) {
+                setUnixSocket(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --unix-socket option");
+            }
+        }
+        else if (arg == "--admin-socket") {
+            if (i + 1 < argc) {
+                config_.adminSocket = argv[++i];
+            } else {
+                throw ConfigException("Missing value for --admin-socket option");
+            }
+        }
+        else if (arg == "--capture") {
+            if (i + 1 < argc) {
+                config_.captureFile = argv[++i];
+            } else {
+                throw ConfigException("Missing value for --capture option");
+            }
+        }
+        else if (arg == "--profile") {
+            if (i + 1 < argc) {
+                config_.profileFile = argv[++i];
+            } else {
+                throw ConfigException("Missing value for --profile option");
+            }
+        }
+        else if (arg == "--profile-hz") {
+            if (i + 1 < argc) {
+                config_.profileHz = parseInteger(arg, argv[++i], 1, 1000);
+            } else {
+                throw ConfigException("Missing value for --profile-hz option");
+            }
+        }
+        else if (arg == "--udp-port") {
+            if (i + 1 < argc) {
+                setUdpPort(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --udp-port option");
+            }
+        }
+        else if (arg == "-w" || arg == "--workers") {
+            if (i + 1 < argc) {
+                setWorkerThreads(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --workers option");
+            }
+        }
+        else if (arg == "--proxy") {
+            if (i + 1 < argc) {
+                addProxyBackends(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --proxy option");
+            }
+        }
+        else if (arg == "--proxy-policy") {
+            if (i + 1 < argc) {
+                std::string policy = argv[++i];
+                if (policy != "least-conn" && policy != "p2c") {
+                    throw ConfigException("--proxy-policy must be 'least-conn' or 'p2c'");
+                }
+                config_.proxyPolicy = policy;
+            } else {
+                throw ConfigException("Missing value for --proxy-policy option");
+            }
+        }
+        else if (arg == "--health-interval") {
+            if (i + 1 < argc) {
+                config_.healthInterval = parseInteger(arg, argv[++i], 1, 3600);
+            } else {
+                throw ConfigException("Missing value for --health-interval option");
+            }
+        }
+        else if (arg == "--health-user") {
+            if (i + 1 < argc) {
+                config_.healthUser = argv[++i];
+            } else {
+                throw ConfigException("Missing value for --health-user option");
+            }
+        }
+        else if (arg == "--processes") {
+            if (i + 1 < argc) {
+                setProcesses(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --processes option");
+            }
+        }
+        else if (arg == "--tcp-nodelay") {
+            config_.tcp.noDelay = true;
+        }
+        else if (arg == "--tcp-quickack") {
+            config_.tcp.quickAck = true;
+        }
+        else if (arg == "--backlog") {
+            if (i + 1 < argc) {
+                config_.tcp.backlog = parseInteger(arg, argv[++i], 1, 65535);
+            } else {
+                throw ConfigException("Missing value for --backlog option");
+            }
+        }
+        else if (arg == "--tcp-defer-accept") {
+            if (i + 1 < argc) {
+                config_.tcp.deferAcceptSeconds = parseInteger(arg, argv[++i], 1, 600);
+            } else {
+                throw ConfigException("Missing value for --tcp-defer-accept option");
+            }
+        }
+        else if (arg == "--tcp-fastopen") {
+            if (i + 1 < argc) {
+                config_.tcp.fastOpenQueue = parseInteger(arg, argv[++i], 1, 65535);
+            } else {
+                throw ConfigException("Missing value for --tcp-fastopen option");
+            }
+        }
+        else if (arg == "--socket-rcvbuf") {
+            if (i + 1 < argc) {
+                config_.tcp.receiveBuffer = static_cast<int>(parseSize(arg, argv[++i], 4096, 64LL << 20));
+            } else {
+                throw ConfigException("Missing value for --socket-rcvbuf option");
+            }
+        }
+        else if (arg == "--socket-sndbuf") {
+            if (i + 1 < argc) {
+                config_.tcp.sendBuffer = static_cast<int>(parseSize(arg, argv[++i], 4096, 64LL << 20));
+            } else {
+                throw ConfigException("Missing value for --socket-sndbuf option");
+            }
+        }
+        else if (arg == "--busy-poll") {
+            if (i + 1 < argc) {
+                config_.tcp.busyPollMicros = parseInteger(arg, argv[++i], 1, 10000);
+            } else {
+                throw ConfigException("Missing value for --busy-poll option");
+            }
+        }
+        else if (arg == "--memory-limit") {
+            if (i + 1 < argc) {
+                config_.memoryLimit = parseSize(arg, argv[++i], 64LL << 10, 1LL << 40);
+            } else {
+                throw ConfigException("Missing value for --memory-limit option");
+            }
+        }
+        else if (arg == "--connection-memory-limit") {
+            if (i + 1 < argc) {
+                config_.connectionMemoryLimit = parseSize(arg, argv[++i], 64LL << 10, 1LL << 40);
+            } else {
+                throw ConfigException("Missing value for --connection-memory-limit option");
+            }
+        }
+        else if (arg == "--memory-wait") {
+            if (i + 1 < argc) {
+                config_.memoryWaitMs = parseInteger(arg, argv[++i], 0, 600000);
+            } else {
+                throw ConfigException("Missing value for --memory-wait option");
+            }
+        }
+        else if (arg == "--max-sessions") {
+            if (i + 1 < argc) {
+                setMaxSessions(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --max-sessions option");
+            }
+        }
+        else if (arg == "--rate-vectors") {
+            if (i + 1 < argc) {
+                config_.rateVectors = parseRate(arg, argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --rate-vectors option");
+            }
+        }
+        else if (arg == "--rate-elements") {
+            if (i + 1 < argc) {
+                config_.rateElements = parseRate(arg, argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --rate-elements option");
+            }
+        }
+        else if (arg == "--log-format") {
+            if (i + 1 < argc) {
+                std::string format = argv[++i];
+                if (format != "text" && format != "binary") {
+                    throw ConfigException("--log-format must be 'text' or 'binary'");
+                }
+                config_.binaryLog = (format == "binary");
+            } else {
+                throw ConfigException("Missing value for --log-format option");
+            }
+        }
+        else if (arg == "--log-sample") {
+            if (i + 1 < argc) {
+                config_.logSampleEvery = parseLogLimit(arg, argv[++i], 1);
+            } else {
+                throw ConfigException("Missing value for --log-sample option");
+            }
+        }
+        else if (arg == "--log-rate") {
+            if (i + 1 < argc) {
+                config_.logRateLimit = parseLogLimit(arg, argv[++i], 0);
+            } else {
+                throw ConfigException("Missing value for --log-rate option");
+            }
+        }
+        else if (arg == "--log-max-size") {
+            if (i + 1 < argc) {
+                setLogMaxSize(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --log-max-size option");
+            }
+        }
+        else if (arg == "--log-max-age") {
+            if (i + 1 < argc) {
+                config_.logMaxAge = parseLogLimit(arg, argv[++i], 1);
+            } else {
+                throw ConfigException("Missing value for --log-max-age option");
+            }
+        }
+        else if (arg == "--log-keep") {
+            if (i + 1 < argc) {
+                config_.logKeepFiles = parseLogLimit(arg, argv[++i], 0);
+            } else {
+                throw ConfigException("Missing value for --log-keep option");
+            }
+        }
+        else if (arg == "--log-no-compress") {
+            config_.logCompress = false;
+        }
+        else if (arg == "--lazy-init") {
+            config_.lazyInit = true;
+        }
+        else if (arg == "--io-stats") {
+            config_.ioStats = true;
+        }
+        else if (arg == "--fairness-key") {
+            if (i + 1 < argc) {
+                std::string key = argv[++i];
+                if (key != "ip" && key != "login") {
+                    throw ConfigException("--fairness-key must be 'ip' or 'login'");
+                }
+                config_.fairnessByLogin = (key == "login");
+            } else {
+                throw ConfigException("Missing value for --fairness-key option");
+            }
+        }
+        else if (arg == "--client-weight") {
+            if (i + 1 < argc) {
+                addClientWeight(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --client-weight option");
+            }
+        }
+        else if (arg == "--acceptor-cpus" || arg == "--io-cpus" || arg == "--compute-cpus") {
+            if (i + 1 >= argc) {
+                throw ConfigException("Missing value for " + arg + " option");
+            }
+            CpuList cpus = parseCpuList(argv[++i]);
+            if (arg == "--acceptor-cpus") {
+                config_.acceptorCpus = cpus;
+            } else if (arg == "--io-cpus") {
+                config_.ioCpus = cpus;
+            } else {
+                config_.computeCpus = cpus;
+            }
+        }
+        else if (arg == "--no-tcp") {
+            config_.tcpEnabled = false;
+        }
+        else if (arg == "--upgrade-socket") {
+            if (i + 1 < argc) {
+                setUpgradeSocket(argv[++i]);
+            } else {
+                throw ConfigException("Missing value for --upgrade-socket option");
+            }
+        }
         else {
             throw ConfigException("Unknown option: " + arg);
         }
@@ -87,6 +408,14 @@ void Config::setLogFile(const std::string& filename) {
     config_.logFile = filename;
 }
 
+void Config::setUnixSocket(const std::string& path) {
+    config_.unixSocket = path;
+}
+
+void Config::setUpgradeSocket(const std::string& path) {
+    config_.upgradeSocket = path;
+}
+
 void Config::setPort(const std::string& portStr) {
     try {
         long port_long = std::stol(portStr);
@@ -101,6 +430,164 @@ void Config::setPort(const std::string& portStr) {
     }
 }
 
+void Config::setUdpPort(const std::string& portStr) {
+    try {
+        long port_long = std::stol(portStr);
+        if (port_long < 1024 || port_long > 65535) {
+            throw ConfigException("UDP port must be in range 1024-65535");
+        }
+        config_.udpPort = static_cast<uint16_t>(port_long);
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid UDP port number: " + portStr);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("UDP port number out of range: " + portStr);
+    }
+}
+
+void Config::setWorkerThreads(const std::string& countStr) {
+    try {
+        long count = std::stol(countStr);
+        if (count < 1 || count > 256) {
+            throw ConfigException("Worker thread count must be in range 1-256");
+        }
+        config_.workerThreads = static_cast<size_t>(count);
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid worker thread count: " + countStr);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Worker thread count out of range: " + countStr);
+    }
+}
+
+void Config::setMaxSessions(const std::string& countStr) {
+    try {
+        long count = std::stol(countStr);
+        if (count < 1 || count > 1024) {
+            throw ConfigException("Max sessions must be in range 1-1024");
+        }
+        config_.maxSessions = static_cast<size_t>(count);
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid max sessions value: " + countStr);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Max sessions value out of range: " + countStr);
+    }
+}
+
+void Config::setLogMaxSize(const std::string& sizeStr) {
+    config_.logMaxSize = static_cast<uint64_t>(parseSize("--log-max-size", sizeStr, 4096, 1LL << 40));
+}
+
+int64_t Config::parseSize(const std::string& option, const std::string& value,
+                          int64_t minimum, int64_t maximum) {
+    try {
+        size_t used = 0;
+        long long size = std::stoll(value, &used);
+        std::string unit = value.substr(used);
+        if (unit == "K" || unit == "k") {
+            size *= 1024LL;
+        } else if (unit == "M" || unit == "m") {
+            size *= 1024LL * 1024;
+        } else if (unit == "G" || unit == "g") {
+            size *= 1024LL * 1024 * 1024;
+        } else if (!unit.empty()) {
+            throw ConfigException("Invalid size unit for " + option + ": " + value);
+        }
+        if (size < minimum || size > maximum) {
+            throw ConfigException(option + " must be in range " + std::to_string(minimum) + "-" +
+                                  std::to_string(maximum) + " bytes");
+        }
+        return size;
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid size for " + option + ": " + value);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Size out of range for " + option + ": " + value);
+    }
+}
+
+int Config::parseInteger(const std::string& option, const std::string& value, long minimum, long maximum) {
+    try {
+        long number = std::stol(value);
+        if (number < minimum || number > maximum) {
+            throw ConfigException(option + " must be in range " + std::to_string(minimum) + "-" +
+                                  std::to_string(maximum));
+        }
+        return static_cast<int>(number);
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid value for " + option + ": " + value);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Value out of range for " + option + ": " + value);
+    }
+}
+
+uint32_t Config::parseLogLimit(const std::string& option, const std::string& value, long minimum) {
+    try {
+        long limit = std::stol(value);
+        if (limit < minimum || limit > 1000000) {
+            throw ConfigException(option + " must be in range " + std::to_string(minimum) + "-1000000");
+        }
+        return static_cast<uint32_t>(limit);
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid value for " + option + ": " + value);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Value out of range for " + option + ": " + value);
+    }
+}
+
+void Config::addProxyBackends(const std::string& list) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string backend = list.substr(start, end - start);
+        if (backend.empty() || backend.find(':') == std::string::npos) {
+            throw ConfigException("--proxy expects HOST:PORT[,HOST:PORT...]: " + list);
+        }
+        config_.proxyBackends.push_back(backend);
+        start = end + 1;
+    }
+}
+
+void Config::setProcesses(const std::string& countStr) {
+    try {
+        long count = std::stol(countStr);
+        if (count < 1 || count > 256) {
+            throw ConfigException("Process count must be in range 1-256");
+        }
+        config_.processes = static_cast<size_t>(count);
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid process count: " + countStr);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Process count out of range: " + countStr);
+    }
+}
+
+double Config::parseRate(const std::string& option, const std::string& value) {
+    try {
+        double rate = std::stod(value);
+        if (rate < 0.0) {
+            throw ConfigException(option + " cannot be negative");
+        }
+        return rate;
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid value for " + option + ": " + value);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Value out of range for " + option + ": " + value);
+    }
+}
+
+void Config::addClientWeight(const std::string& spec) {
+    size_t pos = spec.rfind('=');
+    if (pos == std::string::npos || pos == 0) {
+        throw ConfigException("--client-weight expects KEY=WEIGHT: " + spec);
+    }
+    double weight = parseRate("--client-weight", spec.substr(pos + 1));
+    if (weight <= 0.0) {
+        throw ConfigException("Client weight must be positive: " + spec);
+    }
+    config_.clientWeights[spec.substr(0, pos)] = weight;
+}
+
 void Config::showHelp() {
     std::cout << "Server for vector calculations\n"
               << "Technical requirements:\n"
@@ -108,7 +595,7 @@ void Config::showHelp() {
               << "  - Default client database: /etc/vcalc.conf\n"
               << "  - Default log file: /var/log/vcalc.log\n"
               << "  - Client sends: vectors with float values\n"
-              << "  - Single-threaded request processing\n"
+              << "  - Single-threaded request processing (see --max-sessions)\n"
               << "  - SHA-1 authentication with server-side salt\n"
               << "  - Binary data protocol\n\n"
               << "Usage: server [OPTIONS]\n\n"
@@ -116,12 +603,74 @@ void Config::showHelp() {
               << "  -h, --help          Show this help message\n"
               << "  -c, --config FILE   Client database file (default: /etc/vcalc.conf)\n"
               << "  -l, --log FILE      Log file (default: /var/log/vcalc.log)\n"
-              << "  -p, --port PORT     Server port (default: 33333, range: 1024-65535)\n\n"
+              << "  --log-format FMT    Log as 'text' (default) or 'binary' (read with vcalc-logdump)\n"
+              << "  --log-sample N      Write every N-th INFO/DEBUG message of a kind (default: 1)\n"
+              << "  --log-rate K        At most K INFO/DEBUG messages of a kind per second\n"
+              << "                      (default: unlimited); warnings and errors are never dropped\n"
+              << "  --log-max-size N    Rotate the log when it reaches N bytes (suffix K, M or G)\n"
+              << "  --log-max-age SEC   Rotate the log every SEC seconds\n"
+              << "  --log-keep N        Keep at most N rotated logs (default: all)\n"
+              << "  --log-no-compress   Do not gzip rotated logs\n"
+              << "  -p, --port PORT     Server port (default: 33333, range: 1024-65535)\n"
+              << "  -u, --unix-socket FILE  Also listen on a Unix domain socket (same protocol)\n"
+              << "  --acceptor-cpus L   Pin the accept loop to CPUs L (e.g. 0 or 0-1)\n"
+              << "  --io-cpus L         Pin client session threads to CPUs L\n"
+              << "  --compute-cpus L    Pin compute workers to CPUs L, one CPU per worker\n"
+              << "  --no-tcp            Do not listen on TCP, only on --unix-socket\n"
+              << "  --udp-port PORT     Accept single-vector requests as UDP datagrams\n"
+              << "  --backlog N         Pending connection queue for listen() (default: 10)\n"
+              << "  --tcp-nodelay       Send small replies immediately (disable Nagle)\n"
+              << "  --tcp-quickack      Acknowledge client data without delay (re-armed per request)\n"
+              << "  --tcp-defer-accept S  Wake the accept loop only when the login has arrived\n"
+              << "  --tcp-fastopen N    Accept data in SYN (TCP Fast Open), queue length N\n"
+              << "  --socket-rcvbuf N   Socket receive buffer, bytes (suffix K or M)\n"
+              << "  --socket-sndbuf N   Socket send buffer, bytes (suffix K or M)\n"
+              << "  --busy-poll USEC    Busy-poll the NIC queue in reads (SO_BUSY_POLL)\n"
+              << "  -w, --workers N     Compute threads for tagged requests (default: CPU count)\n"
+              << "  --max-sessions N    Clients served concurrently (default: 1)\n"
+              << "  --memory-limit N    Bytes of client vector data held by the process at once\n"
+              << "                      (suffix K, M or G; default: unlimited)\n"
+              << "  --connection-memory-limit N  Same limit for one connection\n"
+              << "  --memory-wait MS    How long reads wait for memory before the request is\n"
+              << "                      rejected (default: 5000)\n"
+              << "  --proxy LIST        Balance clients over backends HOST:PORT[,HOST:PORT...]\n"
+              << "  --proxy-policy P    Backend choice: 'least-conn' (default) or 'p2c'\n"
+              << "  --health-interval S Seconds between backend health checks (default: 5)\n"
+              << "  --health-user NAME  Login used by health checks (default: user)\n"
+              << "  --processes N       Run N worker processes on the same listening sockets;\n"
+              << "                      crashed workers are restarted (default: 1)\n"
+              << "  --rate-vectors N    Per-client limit, vectors per second (default: unlimited)\n"
+              << "  --rate-elements N   Per-client limit, elements per second (default: unlimited)\n"
+              << "  --fairness-key KEY  Account clients by 'ip' (default) or 'login'\n"
+              << "  --client-weight K=W Weight of client K in the fair compute queue (default: 1)\n"
+              << "  --admin-socket FILE Local control socket: status, log-level, reload-users,\n"
+              << "                      drain on|off, workers N, profile (e.g. socat - UNIX:FILE)\n"
+              << "  --upgrade-socket FILE  Unix socket used to hand listening sockets to a\n"
+              << "                      new server process (default: /tmp/vcalc-upgrade.sock)\n"
+              << "  --lazy-init         Load the client database and start compute threads\n"
+              << "                      on the first connection instead of at startup\n"
+              << "  --capture FILE      Record client traffic and timing for vcalc-replay\n"
+              << "                      (password hashes are not recorded; UDP is not captured)\n"
+              << "  --profile FILE      Sample CPU stacks and write them to FILE in folded\n"
+              << "                      format (for flamegraph.pl) every minute and at exit\n"
+              << "  --profile-hz N      Profiler samples per CPU second (default: 99)\n"
+              << "  --io-stats          Count syscalls, bytes and malloc calls per session and\n"
+              << "                      stage; shown in logs and admin status\n\n"
+              << "Socket activation:\n"
+              << "  When started with LISTEN_FDS/LISTEN_PID (e.g. by a systemd .socket unit),\n"
+              << "  the server uses the inherited listening sockets instead of opening its\n"
+              << "  own. Combined with --lazy-init the first client after an idle exit is\n"
+              << "  served within milliseconds.\n\n"
+              << "Zero-downtime restart:\n"
+              << "  Send SIGUSR2 to the running server. It starts a new copy of itself with\n"
+              << "  the same arguments, passes the listening socket to it, finishes the\n"
+              << "  current client session and exits.\n\n"
               << "Client database format:\n"
               << "  Each line: username:password\n"
               << "  Example: user:P@ssW0rd\n\n"
               << "Examples:\n"
               << "  server -c /etc/my_vcalc.conf -l /var/log/my_vcalc.log -p 8080\n"
               << "  server --config /etc/vcalc.conf --port 44444\n"
-              << "  server -p 12345  # Use custom port with other default settings\n";
+              << "  server -p 12345  # Use custom port with other default settings\n"
+              << "  server -u /run/vcalc.sock  # TCP on 33333 plus a local Unix socket\n";
 }
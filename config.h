@@ -3,12 +3,63 @@
 
 #include <string>
 #include <cstdint>
+#include <unordered_map>
+#include <vector>
 #include "error_handler.h"
+#include "affinity.h"
+#include "network.h"
 
 struct ServerConfig {
     std::string clientDbFile = "/etc/vcalc.conf";
     std::string logFile = "/var/log/vcalc.log";
+    bool binaryLog = false;  // Бинарный лог, читается утилитой vcalc-logdump
+    uint32_t logSampleEvery = 1;  // Писать каждое N-е INFO/DEBUG сообщение шаблона
+    uint32_t logRateLimit = 0;    // Не больше K сообщений шаблона в секунду (0 - без лимита)
+    
+    // Ротация лога (0 - выключена) и хранение ротированных файлов
+    uint64_t logMaxSize = 0;
+    int64_t logMaxAge = 0;
+    size_t logKeepFiles = 0;  // 0 - хранить все
+    bool logCompress = true;
     uint16_t port = 33333;  // Значение по умолчанию
+    std::string upgradeSocket = "/tmp/vcalc-upgrade.sock";
+    std::string adminSocket;  // Пустой путь - административный сокет не используется
+    std::string unixSocket;  // Пустой путь - Unix-сокет не используется
+    bool tcpEnabled = true;
+    uint16_t udpPort = 0;  // 0 - UDP-режим выключен
+    size_t workerThreads = 0;  // 0 - по числу ядер
+    size_t maxSessions = 1;    // 1 - клиенты обслуживаются по очереди
+    size_t processes = 1;      // Больше 1 - главный процесс и рабочие процессы
+    bool lazyInit = false;     // База пользователей и пул потоков - при первом подключении
+    std::string captureFile;   // Запись трафика для vcalc-replay; пустой путь - выключена
+    std::string profileFile;   // Свернутые стеки профилировщика; пустой путь - выключен
+    int profileHz = 99;        // Выборок в секунду процессорного времени
+    bool ioStats = false;      // Счетчики системных вызовов и malloc по сессиям и этапам
+    
+    // Режим балансировщика: клиенты передаются на эти серверы ("host:port")
+    std::vector<std::string> proxyBackends;
+    std::string proxyPolicy = "least-conn";
+    int healthInterval = 5;          // Секунды между проверками бэкендов
+    std::string healthUser = "user";  // Пароль берется из базы клиентов
+    
+    // Настройки TCP-сокетов (--backlog, --tcp-*, --socket-*buf, --busy-poll)
+    TcpTuning tcp;
+    
+    // Бюджет памяти под данные клиентов (0 - без ограничения, учет ведется всегда)
+    uint64_t memoryLimit = 0;            // На процесс
+    uint64_t connectionMemoryLimit = 0;  // На соединение
+    int memoryWaitMs = 5000;             // Сколько чтение ждет свободной памяти
+    
+    // Ограничения на клиента (0 - без ограничения) и веса для справедливой очереди
+    double rateVectors = 0.0;
+    double rateElements = 0.0;
+    bool fairnessByLogin = false;  // Ключ клиента: IP-адрес или логин
+    std::unordered_map<std::string, double> clientWeights;
+    
+    // Привязка потоков: прием подключений, сессии клиентов, вычисления
+    CpuList acceptorCpus;
+    CpuList ioCpus;
+    CpuList computeCpus;
     
     bool validate() const;
 };
@@ -26,6 +77,19 @@ private:
     void setClientDbFile(const std::string& filename);
     void setLogFile(const std::string& filename);
     void setPort(const std::string& portStr);
+    void setUdpPort(const std::string& portStr);
+    void setWorkerThreads(const std::string& countStr);
+    void setMaxSessions(const std::string& countStr);
+    void setProcesses(const std::string& countStr);
+    void addProxyBackends(const std::string& list);
+    void setLogMaxSize(const std::string& sizeStr);
+    int64_t parseSize(const std::string& option, const std::string& value, int64_t minimum, int64_t maximum);
+    int parseInteger(const std::string& option, const std::string& value, long minimum, long maximum);
+    uint32_t parseLogLimit(const std::string& option, const std::string& value, long minimum);
+    double parseRate(const std::string& option, const std::string& value);
+    void addClientWeight(const std::string& spec);
+    void setUpgradeSocket(const std::string& path);
+    void setUnixSocket(const std::string& path);
 };
 
 #endif // CONFIG_H
\ No newline at end of file
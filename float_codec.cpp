@@ -0,0 +1,180 @@
+#include "float_codec.h"
+#include <cstring>
+
+static const size_t LZ_MIN_MATCH = 4;
+static const size_t LZ_MAX_OFFSET = 65535;
+static const int LZ_HASH_BITS = 14;
+
+void shuffleBytes(const uint8_t* input, size_t count, size_t width, uint8_t* output) {
+    for (size_t byte = 0; byte < width; ++byte) {
+        uint8_t* lane = output + byte * count;
+        for (size_t i = 0; i < count; ++i) {
+            lane[i] = input[i * width + byte];
+        }
+    }
+}
+
+void unshuffleBytes(const uint8_t* input, size_t count, size_t width, uint8_t* output) {
+    for (size_t byte = 0; byte < width; ++byte) {
+        const uint8_t* lane = input + byte * count;
+        for (size_t i = 0; i < count; ++i) {
+            output[i * width + byte] = lane[i];
+        }
+    }
+}
+
+static uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void writeLength(std::vector<uint8_t>& output, size_t length) {
+    while (length >= 255) {
+        output.push_back(255);
+        length -= 255;
+    }
+    output.push_back(static_cast<uint8_t>(length));
+}
+
+static void emitSequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t literalCount,
+                         size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4 |
+                                         (matchCode < 15 ? matchCode : 15));
+    output.push_back(token);
+    if (literalCount >= 15) {
+        writeLength(output, literalCount - 15);
+    }
+    output.insert(output.end(), literals, literals + literalCount);
+
+    if (matchLength == 0) {
+        return;
+    }
+    output.push_back(static_cast<uint8_t>(offset & 0xFF));
+    output.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= 15) {
+        writeLength(output, matchCode - 15);
+    }
+}
+
+void lzCompress(const uint8_t* input, size_t size, std::vector<uint8_t>& output) {
+    output.clear();
+    output.reserve(size + size / 255 + 16);
+
+    // Последнее вхождение каждой 4-байтовой последовательности (по хешу)
+    std::vector<uint32_t> table(1u << LZ_HASH_BITS, UINT32_MAX);
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    while (pos + LZ_MIN_MATCH <= size) {
+        uint32_t sequence = read32(input + pos);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        uint32_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(pos);
+
+        if (candidate == UINT32_MAX || pos - candidate > LZ_MAX_OFFSET ||
+            read32(input + candidate) != sequence) {
+            ++pos;
+            continue;
+        }
+
+        size_t length = LZ_MIN_MATCH;
+        while (pos + length < size && input[candidate + length] == input[pos + length]) {
+            ++length;
+        }
+        emitSequence(output, input + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    emitSequence(output, input + anchor, size - anchor, 0, 0);
+}
+
+static bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (ip >= end) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool lzDecompress(const uint8_t* input, size_t size, uint8_t* output, size_t outputSize) {
+    const uint8_t* ip = input;
+    const uint8_t* end = input + size;
+    size_t op = 0;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(ip, end, literalCount)) {
+            return false;
+        }
+        if (literalCount > static_cast<size_t>(end - ip) || literalCount > outputSize - op) {
+            return false;
+        }
+        if (literalCount > 0) {
+            std::memcpy(output + op, ip, literalCount);
+        }
+        ip += literalCount;
+        op += literalCount;
+
+        // Последовательность без совпадения - конец потока
+        if (ip == end) {
+            break;
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(ip, end, matchLength)) {
+            return false;
+        }
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || matchLength > outputSize - op) {
+            return false;
+        }
+
+        // Источник и приемник могут перекрываться (повтор короткого шаблона)
+        const uint8_t* source = output + op - offset;
+        for (size_t i = 0; i < matchLength; ++i) {
+            output[op + i] = source[i];
+        }
+        op += matchLength;
+    }
+
+    return op == outputSize;
+}
+
+void compressElements(const uint8_t* data, size_t count, size_t width, std::vector<uint8_t>& output) {
+    std::vector<uint8_t> shuffled(count * width);
+    shuffleBytes(data, count, width, shuffled.data());
+    lzCompress(shuffled.data(), shuffled.size(), output);
+}
+
+bool decompressElements(const uint8_t* input, size_t size, uint8_t* data, size_t count, size_t width,
+                        std::vector<uint8_t>& scratch) {
+    scratch.resize(count * width);
+    if (!lzDecompress(input, size, scratch.data(), count * width)) {
+        return false;
+    }
+    unshuffleBytes(scratch.data(), count, width, data);
+    return true;
+}
+
+void compressFloats(const uint8_t* data, size_t count, std::vector<uint8_t>& output) {
+    compressElements(data, count, sizeof(float), output);
+}
+
+bool decompressFloats(const uint8_t* input, size_t size, uint8_t* data, size_t count) {
+    std::vector<uint8_t> scratch;
+    return decompressElements(input, size, data, count, sizeof(float), scratch);
+}
@@ -0,0 +1,36 @@
+#ifndef FLOAT_CODEC_H
+#define FLOAT_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Сжатие без потерь для пакетов векторов протокола v2.
+// Байты чисел переставляются по позициям (все первые байты, затем все вторые
+// и т.д.): у близких значений совпадают знак и порядок, и старшие байты
+// превращаются в длинные повторы, которые хорошо сжимает простой LZ-кодек.
+
+// Перестановка байтов массива из count элементов по width байт
+void shuffleBytes(const uint8_t* input, size_t count, size_t width, uint8_t* output);
+void unshuffleBytes(const uint8_t* input, size_t count, size_t width, uint8_t* output);
+
+// LZ-кодек в духе LZ4: последовательности [токен][литералы][смещение][длина].
+// Токен: старшие 4 бита - число литералов, младшие - длина совпадения минус 4;
+// значение 15 продолжается байтами до первого, меньшего 255. Смещение - uint16.
+// Последняя последовательность содержит только литералы.
+void lzCompress(const uint8_t* input, size_t size, std::vector<uint8_t>& output);
+// Проверяет границы: false, если данные повреждены или не дают ровно outputSize байт
+bool lzDecompress(const uint8_t* input, size_t size, uint8_t* output, size_t outputSize);
+
+// Перестановка + LZ для массива из count элементов по width байт.
+// scratch - буфер под переставленные байты (count * width), его можно
+// переиспользовать между вызовами и учитывать в бюджете памяти
+void compressElements(const uint8_t* data, size_t count, size_t width, std::vector<uint8_t>& output);
+bool decompressElements(const uint8_t* input, size_t size, uint8_t* data, size_t count, size_t width,
+                        std::vector<uint8_t>& scratch);
+
+// То же для массива float в порядке little-endian
+void compressFloats(const uint8_t* data, size_t count, std::vector<uint8_t>& output);
+bool decompressFloats(const uint8_t* input, size_t size, uint8_t* data, size_t count);
+
+#endif // FLOAT_CODEC_H
@@ -0,0 +1,129 @@
+#include "io_stats.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+std::atomic<bool> IoStats::enabled_(false);
+
+// Без конструктора: malloc обращается к переменной, когда поток еще создается
+static thread_local IoCounters t_counters;
+
+const char* ioCallName(IoCall call) {
+    switch (call) {
+        case IoCall::RECV: return "recv";
+        case IoCall::SEND: return "send";
+        case IoCall::POLL: return "poll";
+        case IoCall::WRITE: return "write";
+        case IoCall::SOCKOPT: return "setsockopt";
+        default: return "unknown";
+    }
+}
+
+void IoCounters::add(const IoCounters& other) {
+    for (size_t i = 0; i < static_cast<size_t>(IoCall::CALL_COUNT); ++i) {
+        calls[i] += other.calls[i];
+        bytes[i] += other.bytes[i];
+    }
+    allocations += other.allocations;
+    allocatedBytes += other.allocatedBytes;
+}
+
+IoCounters IoCounters::since(const IoCounters& earlier) const {
+    IoCounters delta = {};
+    for (size_t i = 0; i < static_cast<size_t>(IoCall::CALL_COUNT); ++i) {
+        delta.calls[i] = calls[i] - earlier.calls[i];
+        delta.bytes[i] = bytes[i] - earlier.bytes[i];
+    }
+    delta.allocations = allocations - earlier.allocations;
+    delta.allocatedBytes = allocatedBytes - earlier.allocatedBytes;
+    return delta;
+}
+
+uint64_t IoCounters::syscalls() const {
+    uint64_t total = 0;
+    for (uint64_t count : calls) {
+        total += count;
+    }
+    return total;
+}
+
+bool IoCounters::empty() const {
+    return syscalls() == 0 && allocations == 0;
+}
+
+std::string IoCounters::format(uint64_t perItems) const {
+    std::ostringstream out;
+    auto value = [&out, perItems](uint64_t count) {
+        if (perItems > 1) {
+            char text[32];
+            snprintf(text, sizeof(text), "%.2f", static_cast<double>(count) / perItems);
+            out << text;
+        } else {
+            out << count;
+        }
+    };
+
+    for (size_t i = 0; i < static_cast<size_t>(IoCall::CALL_COUNT); ++i) {
+        const char* name = ioCallName(static_cast<IoCall>(i));
+        out << name << "=";
+        value(calls[i]);
+        // У poll и setsockopt нет полезной нагрузки
+        if (static_cast<IoCall>(i) != IoCall::POLL && static_cast<IoCall>(i) != IoCall::SOCKOPT) {
+            out << " " << name << "_bytes=";
+            value(bytes[i]);
+        }
+        out << " ";
+    }
+    out << "malloc=";
+    value(allocations);
+    out << " malloc_bytes=";
+    value(allocatedBytes);
+    return out.str();
+}
+
+IoCounters IoStats::current() {
+    return t_counters;
+}
+
+void IoStats::record(IoCall kind, ssize_t bytes) {
+    size_t index = static_cast<size_t>(kind);
+    t_counters.calls[index]++;
+    if (bytes > 0) {
+        t_counters.bytes[index] += static_cast<uint64_t>(bytes);
+    }
+}
+
+#ifdef __GLIBC__
+// Перехват выделений: исполняемый файл подменяет malloc для всех библиотек
+// процесса, а память по-прежнему выделяет glibc. free, memalign и прочие
+// функции не перехватываются - они работают с той же кучей.
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+static inline void countAllocation(size_t size) {
+    if (IoStats::enabled()) {
+        t_counters.allocations++;
+        t_counters.allocatedBytes += size;
+    }
+}
+
+void* malloc(size_t size) noexcept {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept {
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef IO_STATS_H
+#define IO_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+// Счетчики системных вызовов и выделений памяти горячего пути (--io-stats).
+// Вызовы учитываются в обертках сервера вокруг recv/send/poll и записи
+// лога; вызовы внутри libc (например, stat в localtime) сюда не попадают.
+// Выделения считает перехват malloc/calloc/realloc, через который идут
+// и operator new, и Crypto++, и zlib. Потоки копят счетчики в thread_local
+// без атомарных операций, а сессия забирает прирост на границах этапов.
+enum class IoCall {
+    RECV,     // recv и чтение eventfd колец
+    SEND,
+    POLL,
+    WRITE,    // Сброс лога, файл --capture, eventfd колец
+    SOCKOPT,  // setsockopt перед запросом (TCP_QUICKACK)
+    CALL_COUNT
+};
+
+const char* ioCallName(IoCall call);
+
+struct IoCounters {
+    uint64_t calls[static_cast<size_t>(IoCall::CALL_COUNT)];
+    uint64_t bytes[static_cast<size_t>(IoCall::CALL_COUNT)];
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+
+    void add(const IoCounters& other);
+    IoCounters since(const IoCounters& earlier) const;
+    uint64_t syscalls() const;
+    bool empty() const;
+    // "recv=3 recv_bytes=80 ... malloc=12 malloc_bytes=960"; при perItems > 1 -
+    // средние на единицу (например, на вектор) с двумя знаками
+    std::string format(uint64_t perItems = 1) const;
+};
+
+class IoStats {
+public:
+    // Включается один раз при запуске: перехват malloc без этого флага
+    // стоит одной проверки
+    static void enable() { enabled_.store(true, std::memory_order_relaxed); }
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Ошибка (bytes < 0) учитывается как вызов без данных
+    static void call(IoCall kind, ssize_t bytes) {
+        if (enabled()) {
+            record(kind, bytes);
+        }
+    }
+
+    // Счетчики вызывающего потока с его запуска
+    static IoCounters current();
+
+private:
+    static std::atomic<bool> enabled_;
+
+    static void record(IoCall kind, ssize_t bytes);
+};
+
+#endif // IO_STATS_H
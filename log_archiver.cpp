@@ -0,0 +1,131 @@
+#include "log_archiver.h"
+#include "error_handler.h"
+#include "affinity.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include <zlib.h>
+
+LogArchiver::LogArchiver(const std::string& logFile, size_t keepFiles, bool compress)
+    : logFile_(logFile), keepFiles_(keepFiles), compress_(compress), stopping_(false) {
+    thread_ = std::thread(&LogArchiver::workerLoop, this);
+}
+
+LogArchiver::~LogArchiver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void LogArchiver::enqueue(const std::string& rotatedFile) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(rotatedFile);
+    }
+    condition_.notify_one();
+}
+
+void LogArchiver::workerLoop() {
+    nameCurrentThread("vcalc-logzip");
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            // Очередь дорабатывается до конца, чтобы не оставить несжатых файлов
+            if (queue_.empty()) {
+                return;
+            }
+            path = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        if (compress_ && !compressFile(path)) {
+            ErrorHandler::handleWarning("Failed to compress rotated log file: " + path);
+        }
+        pruneOldFiles();
+    }
+}
+
+bool LogArchiver::compressFile(const std::string& path) {
+    FILE* input = fopen(path.c_str(), "rb");
+    if (!input) {
+        return false;
+    }
+
+    std::string target = path + ".gz";
+    gzFile output = gzopen(target.c_str(), "wb6");
+    if (!output) {
+        fclose(input);
+        return false;
+    }
+
+    std::vector<char> buffer(1 << 16);
+    bool ok = true;
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+        if (gzwrite(output, buffer.data(), static_cast<unsigned>(bytesRead)) != static_cast<int>(bytesRead)) {
+            ok = false;
+            break;
+        }
+    }
+    if (ferror(input)) {
+        ok = false;
+    }
+    fclose(input);
+
+    if (gzclose(output) != Z_OK) {
+        ok = false;
+    }
+
+    if (!ok) {
+        unlink(target.c_str());
+        return false;
+    }
+    unlink(path.c_str());
+    return true;
+}
+
+void LogArchiver::pruneOldFiles() {
+    if (keepFiles_ == 0) {
+        return;
+    }
+
+    size_t slash = logFile_.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : logFile_.substr(0, slash);
+    std::string prefix = (slash == std::string::npos ? logFile_ : logFile_.substr(slash + 1)) + ".";
+    if (slash == 0) {
+        directory = "/";
+    }
+
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+
+    // Суффикс ротированного файла начинается с метки времени UTC,
+    // поэтому сортировка по имени совпадает с сортировкой по возрасту
+    std::vector<std::string> rotated;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+            isdigit(static_cast<unsigned char>(name[prefix.size()]))) {
+            rotated.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    if (rotated.size() <= keepFiles_) {
+        return;
+    }
+    std::sort(rotated.begin(), rotated.end());
+    for (size_t i = 0; i + keepFiles_ < rotated.size(); ++i) {
+        unlink((directory + "/" + rotated[i]).c_str());
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef LOG_ARCHIVER_H
+#define LOG_ARCHIVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Фоновая обработка ротированных файлов лога: сжатие в gzip и удаление
+// старых архивов. Logger только переименовывает файл и ставит его в очередь,
+// поэтому ротация не задерживает обработку запросов.
+class LogArchiver {
+private:
+    std::string logFile_;
+    size_t keepFiles_;
+    bool compress_;
+
+    std::thread thread_;
+    std::deque<std::string> queue_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_;
+
+public:
+    // keepFiles - сколько ротированных файлов хранить (0 - все)
+    LogArchiver(const std::string& logFile, size_t keepFiles, bool compress);
+    ~LogArchiver();
+
+    LogArchiver(const LogArchiver&) = delete;
+    LogArchiver& operator=(const LogArchiver&) = delete;
+
+    void enqueue(const std::string& rotatedFile);
+
+private:
+    void workerLoop();
+    bool compressFile(const std::string& path);
+    void pruneOldFiles();
+};
+
+#endif // LOG_ARCHIVER_H
@@ -0,0 +1,245 @@
+#include "log_format.h"
+#include <cstring>
+
+const char BINARY_LOG_MAGIC[8] = {'V', 'C', 'L', 'O', 'G', 'B', 'N', '1'};
+
+static const char* const FORMAT_TEMPLATES[] = {
+    "{}",
+    "Client connected from: {}",
+    "New client connection from: {}",
+    "Client disconnected: {}",
+    "Ready for next client connection...",
+    "=== START handling client: {} ===",
+    "=== COMPLETED handling client: {} ===",
+    "Authentication attempt for user: {}",
+    "Authentication successful for user: {}",
+    "User authenticated successfully: {}",
+    "Sent salt to client: {}",
+    "Received hash from client: {}",
+    "Sent authentication result: {}",
+    "Waiting for login...",
+    "Received login: {}",
+    "Waiting for {} bytes...",
+    "Successfully received {} bytes",
+    "Waiting for number of vectors...",
+    "Number of vectors: {}",
+    "Processing vector {}",
+    "Waiting for size of vector {}",
+    "Vector {} size: {}",
+    "Vector {} element {}: {}",
+    "Vector {} data: {}",
+    "Vector {} product: {}",
+    "Vector {} product: -inf (OVERFLOW)",
+    "Sending result for vector {}: {}",
+    "Successfully sent result for vector {}",
+    "Completed processing all {} vectors",
+    "Tagged request {} size {}",
+    "Suppressed {} messages like: {}",
+    "Framed batch of {} vectors, {} elements, {} payload bytes",
+    "Framed batch of {} {} vectors, {} elements, {} payload bytes"
+};
+
+static_assert(sizeof(FORMAT_TEMPLATES) / sizeof(FORMAT_TEMPLATES[0]) ==
+              static_cast<size_t>(LogFormat::FORMAT_COUNT),
+              "Every LogFormat needs a template");
+
+const char* logFormatTemplate(LogFormat format) {
+    size_t index = static_cast<size_t>(format);
+    if (index >= static_cast<size_t>(LogFormat::FORMAT_COUNT)) {
+        return nullptr;
+    }
+    return FORMAT_TEMPLATES[index];
+}
+
+static void appendArgument(std::string& out, const LogArg& arg) {
+    switch (arg.type) {
+        case LogArg::INT:
+            out += std::to_string(arg.i);
+            break;
+        case LogArg::UINT:
+            out += std::to_string(arg.u);
+            break;
+        case LogArg::FLOAT:
+            out += std::to_string(static_cast<float>(arg.f));
+            break;
+        case LogArg::DOUBLE:
+            out += std::to_string(arg.f);
+            break;
+        case LogArg::STRING:
+            out.append(static_cast<const char*>(arg.data), arg.size);
+            break;
+        case LogArg::FLOAT_ARRAY: {
+            // float в массиве может лежать невыровненным внутри записи лога
+            const char* bytes = static_cast<const char*>(arg.data);
+            out += "[";
+            for (size_t i = 0; i < arg.size; ++i) {
+                float value;
+                std::memcpy(&value, bytes + i * sizeof(float), sizeof(float));
+                if (i > 0) out += ", ";
+                out += std::to_string(value);
+            }
+            out += "]";
+            break;
+        }
+    }
+}
+
+std::string renderLogMessage(LogFormat format, const LogArg* args, size_t count) {
+    const char* pattern = logFormatTemplate(format);
+    std::string result;
+    if (!pattern) {
+        result = "<unknown log format " + std::to_string(static_cast<unsigned>(format)) + ">";
+        for (size_t i = 0; i < count; ++i) {
+            result += " ";
+            appendArgument(result, args[i]);
+        }
+        return result;
+    }
+
+    size_t next = 0;
+    for (const char* p = pattern; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            if (next < count) {
+                appendArgument(result, args[next++]);
+            }
+            ++p;
+        } else {
+            result += *p;
+        }
+    }
+    return result;
+}
+
+template <typename T>
+static void appendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void encodeLogRecord(std::string& out, uint64_t timeNs, uint8_t level, LogFormat format,
+                     const LogArg* args, size_t count) {
+    if (count > BINARY_LOG_MAX_ARGS) {
+        count = BINARY_LOG_MAX_ARGS;
+    }
+
+    size_t start = out.size();
+    appendRaw<uint32_t>(out, 0);
+    appendRaw<uint64_t>(out, timeNs);
+    appendRaw<uint8_t>(out, level);
+    appendRaw<uint16_t>(out, static_cast<uint16_t>(format));
+    appendRaw<uint8_t>(out, static_cast<uint8_t>(count));
+
+    for (size_t i = 0; i < count; ++i) {
+        const LogArg& arg = args[i];
+        appendRaw<uint8_t>(out, arg.type);
+        switch (arg.type) {
+            case LogArg::INT:
+                appendRaw<int64_t>(out, arg.i);
+                break;
+            case LogArg::UINT:
+                appendRaw<uint64_t>(out, arg.u);
+                break;
+            case LogArg::FLOAT:
+                appendRaw<float>(out, static_cast<float>(arg.f));
+                break;
+            case LogArg::DOUBLE:
+                appendRaw<double>(out, arg.f);
+                break;
+            case LogArg::STRING: {
+                size_t length = arg.size > UINT16_MAX ? UINT16_MAX : arg.size;
+                appendRaw<uint16_t>(out, static_cast<uint16_t>(length));
+                out.append(static_cast<const char*>(arg.data), length);
+                break;
+            }
+            case LogArg::FLOAT_ARRAY:
+                appendRaw<uint32_t>(out, static_cast<uint32_t>(arg.size));
+                out.append(static_cast<const char*>(arg.data), arg.size * sizeof(float));
+                break;
+        }
+    }
+
+    uint32_t length = static_cast<uint32_t>(out.size() - start);
+    std::memcpy(&out[start], &length, sizeof(length));
+}
+
+template <typename T>
+static bool readRaw(const char*& cursor, const char* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+size_t decodeLogRecord(const char* buffer, size_t available, uint64_t& timeNs, uint8_t& level,
+                       LogFormat& format, LogArg* args, size_t& count) {
+    const char* cursor = buffer;
+    uint32_t length = 0;
+    if (!readRaw(cursor, buffer + available, length) || length > available || length < 16) {
+        return 0;
+    }
+    const char* end = buffer + length;
+
+    uint16_t formatId = 0;
+    uint8_t argc = 0;
+    if (!readRaw(cursor, end, timeNs) || !readRaw(cursor, end, level) ||
+        !readRaw(cursor, end, formatId) || !readRaw(cursor, end, argc) ||
+        argc > BINARY_LOG_MAX_ARGS) {
+        return 0;
+    }
+    format = static_cast<LogFormat>(formatId);
+
+    for (size_t i = 0; i < argc; ++i) {
+        uint8_t type = 0;
+        if (!readRaw(cursor, end, type)) {
+            return 0;
+        }
+        LogArg& arg = args[i];
+        arg = LogArg(0);
+        switch (type) {
+            case LogArg::INT:
+                if (!readRaw(cursor, end, arg.i)) return 0;
+                break;
+            case LogArg::UINT:
+                arg.type = LogArg::UINT;
+                if (!readRaw(cursor, end, arg.u)) return 0;
+                break;
+            case LogArg::FLOAT: {
+                float value = 0;
+                if (!readRaw(cursor, end, value)) return 0;
+                arg = LogArg(value);
+                break;
+            }
+            case LogArg::DOUBLE: {
+                double value = 0;
+                if (!readRaw(cursor, end, value)) return 0;
+                arg = LogArg(value);
+                break;
+            }
+            case LogArg::STRING: {
+                uint16_t size = 0;
+                if (!readRaw(cursor, end, size) || end - cursor < size) return 0;
+                arg.type = LogArg::STRING;
+                arg.data = cursor;
+                arg.size = size;
+                cursor += size;
+                break;
+            }
+            case LogArg::FLOAT_ARRAY: {
+                uint32_t size = 0;
+                if (!readRaw(cursor, end, size) ||
+                    static_cast<size_t>(end - cursor) / sizeof(float) < size) return 0;
+                arg.type = LogArg::FLOAT_ARRAY;
+                arg.data = cursor;
+                arg.size = size;
+                cursor += size * sizeof(float);
+                break;
+            }
+            default:
+                return 0;
+        }
+    }
+
+    count = argc;
+    return length;
+}
@@ -0,0 +1,114 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Шаблоны частых сообщений лога. В бинарном логе вместо текста пишется
+// номер шаблона и сырые значения аргументов, текст собирает vcalc-logdump.
+// Номера записаны в файлы логов: существующие значения не менять,
+// новые шаблоны добавлять только в конец.
+enum class LogFormat : uint16_t {
+    FREE_TEXT = 0,
+    CLIENT_CONNECTED = 1,
+    NEW_CLIENT_CONNECTION = 2,
+    CLIENT_DISCONNECTED = 3,
+    READY_FOR_NEXT_CLIENT = 4,
+    START_HANDLING = 5,
+    COMPLETED_HANDLING = 6,
+    AUTH_ATTEMPT = 7,
+    AUTH_SUCCESS = 8,
+    USER_AUTHENTICATED = 9,
+    SENT_SALT = 10,
+    RECEIVED_HASH = 11,
+    SENT_AUTH_RESULT = 12,
+    WAITING_LOGIN = 13,
+    RECEIVED_LOGIN = 14,
+    WAITING_BYTES = 15,
+    RECEIVED_BYTES = 16,
+    WAITING_NUM_VECTORS = 17,
+    NUMBER_OF_VECTORS = 18,
+    PROCESSING_VECTOR = 19,
+    WAITING_VECTOR_SIZE = 20,
+    VECTOR_SIZE = 21,
+    VECTOR_ELEMENT = 22,
+    VECTOR_DATA = 23,
+    VECTOR_PRODUCT = 24,
+    VECTOR_OVERFLOW = 25,
+    SENDING_RESULT = 26,
+    RESULT_SENT = 27,
+    COMPLETED_VECTORS = 28,
+    TAGGED_REQUEST = 29,
+    LOG_SUPPRESSED = 30,
+    FRAMED_BATCH = 31,
+    FRAMED_TYPED_BATCH = 32,
+    FORMAT_COUNT
+};
+
+// Шаблон с местами "{}" под аргументы; nullptr для неизвестного номера
+const char* logFormatTemplate(LogFormat format);
+
+// Аргумент сообщения. Не владеет строками и массивами - они должны
+// жить до конца вызова Logger::logf.
+struct LogArg {
+    enum Type : uint8_t {
+        INT = 1,
+        UINT = 2,
+        FLOAT = 3,
+        DOUBLE = 4,
+        STRING = 5,
+        FLOAT_ARRAY = 6
+    };
+
+    Type type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double f;
+    };
+    const void* data;
+    size_t size;
+
+    LogArg(int value) : type(INT), i(value), data(nullptr), size(0) {}
+    LogArg(long value) : type(INT), i(value), data(nullptr), size(0) {}
+    LogArg(long long value) : type(INT), i(value), data(nullptr), size(0) {}
+    LogArg(unsigned value) : type(UINT), u(value), data(nullptr), size(0) {}
+    LogArg(unsigned long value) : type(UINT), u(value), data(nullptr), size(0) {}
+    LogArg(unsigned long long value) : type(UINT), u(value), data(nullptr), size(0) {}
+    LogArg(float value) : type(FLOAT), f(value), data(nullptr), size(0) {}
+    LogArg(double value) : type(DOUBLE), f(value), data(nullptr), size(0) {}
+    LogArg(const std::string& value) : type(STRING), u(0), data(value.data()), size(value.size()) {}
+    LogArg(const char* value) : type(STRING), u(0), data(value), size(std::char_traits<char>::length(value)) {}
+
+    static LogArg floats(const float* values, size_t count) {
+        LogArg arg(0);
+        arg.type = FLOAT_ARRAY;
+        arg.data = values;
+        arg.size = count;
+        return arg;
+    }
+};
+
+// Текст сообщения по шаблону; одинаков для текстового лога и vcalc-logdump
+std::string renderLogMessage(LogFormat format, const LogArg* args, size_t count);
+
+// Бинарный лог: заголовок файла и запись
+//   [uint32 длина записи][uint64 время, нс][uint8 уровень][uint16 шаблон]
+//   [uint8 число аргументов] и аргументы [uint8 тип][значение]
+// Числа - 8 байт, float - 4 байта, строка - [uint16 длина][байты],
+// массив float - [uint32 количество][элементы]. Числа пишутся в порядке
+// байтов хоста без преобразования: vcalc-logdump читает лог, записанный
+// на машине той же архитектуры.
+extern const char BINARY_LOG_MAGIC[8];
+const size_t BINARY_LOG_MAX_ARGS = 16;
+
+void encodeLogRecord(std::string& out, uint64_t timeNs, uint8_t level, LogFormat format,
+                     const LogArg* args, size_t count);
+
+// Разбор записи из буфера. Аргументы-строки указывают внутрь buffer.
+// Возвращает длину записи или 0, если запись неполная или повреждена.
+size_t decodeLogRecord(const char* buffer, size_t available, uint64_t& timeNs, uint8_t& level,
+                       LogFormat& format, LogArg* args, size_t& count);
+
+#endif // LOG_FORMAT_H
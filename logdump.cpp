@@ -0,0 +1,119 @@
+// vcalc-logdump: перевод бинарного лога сервера (--log-format binary) в текст.
+// Вывод совпадает с текстовым логом, поэтому к нему применимы те же grep/awk.
+#include "log_format.h"
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+static const char* levelName(uint8_t level) {
+    // Порядок совпадает с LogLevel в logger.h
+    switch (level) {
+        case 0: return "INFO";
+        case 1: return "WARNING";
+        case 2: return "ERROR";
+        case 3: return "DEBUG";
+        default: return "UNKNOWN";
+    }
+}
+
+static std::string formatTime(uint64_t timeNs, bool precise) {
+    time_t seconds = static_cast<time_t>(timeNs / 1000000000ULL);
+    struct tm local;
+    localtime_r(&seconds, &local);
+
+    char buffer[64];
+    size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    if (precise) {
+        snprintf(buffer + length, sizeof(buffer) - length, ".%09llu",
+                 static_cast<unsigned long long>(timeNs % 1000000000ULL));
+    }
+    return buffer;
+}
+
+static bool dumpStream(std::istream& in, const std::string& name, bool precise) {
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(BINARY_LOG_MAGIC) ||
+        memcmp(data.data(), BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC)) != 0) {
+        std::cerr << name << ": not a binary vcalc log" << std::endl;
+        return false;
+    }
+
+    size_t offset = sizeof(BINARY_LOG_MAGIC);
+    std::vector<LogArg> args(BINARY_LOG_MAX_ARGS, LogArg(0));
+    std::string line;
+
+    while (offset < data.size()) {
+        uint64_t timeNs = 0;
+        uint8_t level = 0;
+        LogFormat format = LogFormat::FREE_TEXT;
+        size_t count = 0;
+        size_t length = decodeLogRecord(data.data() + offset, data.size() - offset,
+                                        timeNs, level, format, args.data(), count);
+        if (length == 0) {
+            // Хвост без полной записи бывает, если сервер был убит во время записи
+            std::cerr << name << ": damaged or truncated record at offset " << offset << std::endl;
+            return false;
+        }
+
+        line = formatTime(timeNs, precise);
+        line += " [";
+        line += levelName(level);
+        line += "] ";
+        line += renderLogMessage(format, args.data(), count);
+        std::cout << line << '\n';
+
+        offset += length;
+    }
+    return true;
+}
+
+static void showHelp() {
+    std::cout << "Usage: vcalc-logdump [--precise] [FILE...]\n\n"
+              << "Prints binary server logs (server --log-format binary) as text.\n"
+              << "Reads standard input when no FILE or '-' is given.\n\n"
+              << "Options:\n"
+              << "  --precise   Print timestamps with nanoseconds\n"
+              << "  -h, --help  Show this help message\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    bool precise = false;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            showHelp();
+            return 0;
+        } else if (arg == "--precise") {
+            precise = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        files.push_back("-");
+    }
+
+    bool ok = true;
+    for (const auto& file : files) {
+        if (file == "-") {
+            ok = dumpStream(std::cin, "<stdin>", precise) && ok;
+            continue;
+        }
+        std::ifstream in(file, std::ios::binary);
+        if (!in.is_open()) {
+            std::cerr << file << ": cannot open file" << std::endl;
+            ok = false;
+            continue;
+        }
+        ok = dumpStream(in, file, precise) && ok;
+    }
+    std::cout.flush();
+    return ok ? 0 : 1;
+}
@@ -1,18 +1,52 @@
 #include "logger.h"
+#include "io_stats.h"
+#include <ctime>
+#include <cstdio>
+#include <sys/stat.h>
+#include <sys/time.h>
 
-Logger::Logger(const std::string& logFile) : logFile_(logFile), enabled_(true) {
+// Как часто в лог попадают сводки об отброшенных сообщениях
+static const int64_t LOG_SUMMARY_INTERVAL = 10;
+
+// Грубые часы дешевле обычных: проверка лимита стоит на горячем пути
+static int64_t coarseSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec;
+}
+
+Logger::Logger(const std::string& logFile, LogOutput output)
+    : logFile_(logFile), enabled_(true), output_(output),
+      sampleEvery_(1), ratePerSecond_(0), lastSummary_(coarseSeconds()),
+      minSeverity_(severity(LogLevel::DEBUG)),
+      maxFileSize_(0), maxFileAge_(0), fileSize_(0), fileOpenedAt_(0) {
     ensureFileOpen();
 }
 
 Logger::~Logger() {
+    reportSuppressed(true);
     if (fileStream_.is_open()) {
         fileStream_.close();
     }
+    // archiver_ дожимает оставшиеся файлы в своем деструкторе
 }
 
 void Logger::ensureFileOpen() {
     if (!fileStream_.is_open()) {
-        fileStream_.open(logFile_, std::ios::app);
+        struct stat info;
+        fileSize_ = stat(logFile_.c_str(), &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+        fileOpenedAt_ = coarseSeconds();
+        
+        if (output_ == LogOutput::BINARY) {
+            fileStream_.open(logFile_, std::ios::app | std::ios::binary);
+            if (fileStream_.is_open() && fileSize_ == 0) {
+                fileStream_.write(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+                fileStream_.flush();
+                fileSize_ = sizeof(BINARY_LOG_MAGIC);
+            }
+        } else {
+            fileStream_.open(logFile_, std::ios::app);
+        }
         if (!fileStream_.is_open()) {
             enabled_ = false;
             ErrorHandler::handleWarning("Cannot open log file: " + logFile_);
@@ -22,14 +56,226 @@ void Logger::ensureFileOpen() {
 
 void Logger::log(LogLevel level, const std::string& message) {
     if (!enabled_) return;
+    if (severity(level) < minSeverity_.load(std::memory_order_relaxed)) return;
+    
+    if (output_ == LogOutput::BINARY) {
+        LogArg arg(message);
+        writeBinary(level, LogFormat::FREE_TEXT, &arg, 1);
+        return;
+    }
+    writeText(level, message);
+}
+
+void Logger::logf(LogLevel level, LogFormat format, std::initializer_list<LogArg> args) {
+    if (!enabled_) return;
+    if (severity(level) < minSeverity_.load(std::memory_order_relaxed)) return;
+    if (!admit(level, format)) return;
     
+    if (output_ == LogOutput::BINARY) {
+        writeBinary(level, format, args.begin(), args.size());
+        return;
+    }
+    writeText(level, renderLogMessage(format, args.begin(), args.size()));
+}
+
+void Logger::setRotation(uint64_t maxFileSize, int64_t maxFileAge, size_t keepFiles, bool compress) {
+    std::lock_guard<std::mutex> lock(logMutex_);
+    maxFileSize_ = maxFileSize;
+    maxFileAge_ = maxFileAge;
+    archiver_.reset();
+    if (maxFileSize_ > 0 || maxFileAge_ > 0) {
+        archiver_.reset(new LogArchiver(logFile_, keepFiles, compress));
+    }
+}
+
+void Logger::rotateIfNeeded() {
+    // Вызывается под logMutex_ после каждой записи
+    if (!archiver_) {
+        return;
+    }
+    bool tooBig = maxFileSize_ > 0 && fileSize_ >= maxFileSize_;
+    bool tooOld = maxFileAge_ > 0 && coarseSeconds() - fileOpenedAt_ >= maxFileAge_;
+    if (!tooBig && !tooOld) {
+        return;
+    }
+    
+    // Имя с меткой времени UTC до микросекунд: сортировка по имени = по возрасту.
+    // Местное время для этого не годится - при переходе на летнее время
+    // или смене TZ имена идут не по порядку, и очистка удалит не те файлы
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    struct tm utc;
+    gmtime_r(&now.tv_sec, &utc);
+    char suffix[32];
+    size_t length = strftime(suffix, sizeof(suffix), ".%Y%m%d-%H%M%S", &utc);
+    snprintf(suffix + length, sizeof(suffix) - length, "-%06ld", static_cast<long>(now.tv_usec));
+    std::string rotated = logFile_ + suffix;
+    
+    // Переименование не трогает открытый дескриптор; остаток буфера
+    // уходит в старый файл при закрытии, новые записи - в новый файл
+    if (rename(logFile_.c_str(), rotated.c_str()) != 0) {
+        // Не удалось - пробуем снова через полный интервал, а не на каждой записи
+        fileOpenedAt_ = coarseSeconds();
+        fileSize_ = 0;
+        return;
+    }
+    fileStream_.close();
+    ensureFileOpen();
+    archiver_->enqueue(rotated);
+}
+
+void Logger::flush() {
+    std::lock_guard<std::mutex> lock(logMutex_);
+    if (fileStream_.is_open()) {
+        fileStream_.flush();
+    }
+}
+
+int Logger::severity(LogLevel level) {
+    // Порядок в LogLevel исторический, поэтому важность задается явно
+    switch (level) {
+        case LogLevel::DEBUG: return 0;
+        case LogLevel::INFO: return 1;
+        case LogLevel::WARNING: return 2;
+        case LogLevel::ERROR: return 3;
+        default: return 1;
+    }
+}
+
+void Logger::setLevel(LogLevel level) {
+    minSeverity_.store(severity(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const {
+    switch (minSeverity_.load(std::memory_order_relaxed)) {
+        case 0: return LogLevel::DEBUG;
+        case 2: return LogLevel::WARNING;
+        case 3: return LogLevel::ERROR;
+        default: return LogLevel::INFO;
+    }
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    if (name == "debug") level = LogLevel::DEBUG;
+    else if (name == "info") level = LogLevel::INFO;
+    else if (name == "warning") level = LogLevel::WARNING;
+    else if (name == "error") level = LogLevel::ERROR;
+    else return false;
+    return true;
+}
+
+std::string Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "debug";
+        case LogLevel::INFO: return "info";
+        case LogLevel::WARNING: return "warning";
+        case LogLevel::ERROR: return "error";
+        default: return "unknown";
+    }
+}
+
+void Logger::setSampling(uint32_t sampleEvery, uint32_t ratePerSecond) {
+    sampleEvery_ = sampleEvery > 0 ? sampleEvery : 1;
+    ratePerSecond_ = ratePerSecond;
+}
+
+bool Logger::admit(LogLevel level, LogFormat format) {
+    // Предупреждения и ошибки пишутся всегда
+    if (level == LogLevel::WARNING || level == LogLevel::ERROR) {
+        return true;
+    }
+    if (sampleEvery_ <= 1 && ratePerSecond_ == 0) {
+        return true;
+    }
+    size_t index = static_cast<size_t>(format);
+    if (format == LogFormat::FREE_TEXT || index >= static_cast<size_t>(LogFormat::FORMAT_COUNT)) {
+        return true;
+    }
+    
+    LogLimiter& limiter = limiters_[index];
+    bool accepted = true;
+    
+    if (sampleEvery_ > 1 &&
+        limiter.seen.fetch_add(1, std::memory_order_relaxed) % sampleEvery_ != 0) {
+        accepted = false;
+    }
+    
+    if (accepted && ratePerSecond_ > 0) {
+        int64_t now = coarseSeconds();
+        int64_t window = limiter.window.load(std::memory_order_relaxed);
+        if (window != now && limiter.window.compare_exchange_strong(window, now)) {
+            limiter.windowCount.store(0, std::memory_order_relaxed);
+        }
+        if (limiter.windowCount.fetch_add(1, std::memory_order_relaxed) >= ratePerSecond_) {
+            accepted = false;
+        }
+    }
+    
+    if (!accepted) {
+        limiter.suppressed.fetch_add(1, std::memory_order_relaxed);
+        reportSuppressed();
+    }
+    return accepted;
+}
+
+void Logger::reportSuppressed(bool force) {
+    if (!enabled_) return;
+    
+    int64_t now = coarseSeconds();
+    int64_t last = lastSummary_.load(std::memory_order_relaxed);
+    if (!force && (now - last < LOG_SUMMARY_INTERVAL ||
+                   !lastSummary_.compare_exchange_strong(last, now))) {
+        return;
+    }
+    
+    for (size_t i = 0; i < static_cast<size_t>(LogFormat::FORMAT_COUNT); ++i) {
+        uint64_t count = limiters_[i].suppressed.exchange(0, std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        LogArg args[] = {LogArg(count), LogArg(logFormatTemplate(static_cast<LogFormat>(i)))};
+        if (output_ == LogOutput::BINARY) {
+            writeBinary(LogLevel::INFO, LogFormat::LOG_SUPPRESSED, args, 2);
+        } else {
+            writeText(LogLevel::INFO, renderLogMessage(LogFormat::LOG_SUPPRESSED, args, 2));
+        }
+    }
+}
+
+void Logger::writeText(LogLevel level, const std::string& message) {
     std::lock_guard<std::mutex> lock(logMutex_);
     ensureFileOpen();
     
     if (fileStream_.is_open()) {
-        fileStream_ << getCurrentTime() << " [" << levelToString(level) << "] " 
-                   << message << std::endl;
+        std::string line = getCurrentTime() + " [" + levelToString(level) + "] " + message + "\n";
+        fileStream_.write(line.data(), line.size());
         fileStream_.flush();
+        IoStats::call(IoCall::WRITE, line.size());
+        fileSize_ += line.size();
+        rotateIfNeeded();
+    }
+}
+
+void Logger::writeBinary(LogLevel level, LogFormat format, const LogArg* args, size_t count) {
+    // Запись собирается без блокировки в буфер потока
+    thread_local std::string record;
+    record.clear();
+    uint64_t timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    encodeLogRecord(record, timeNs, static_cast<uint8_t>(level), format, args, count);
+    
+    std::lock_guard<std::mutex> lock(logMutex_);
+    ensureFileOpen();
+    
+    if (fileStream_.is_open()) {
+        fileStream_.write(record.data(), record.size());
+        // Сброс на диск только для важных сообщений, остальное копится в буфере
+        if (level == LogLevel::WARNING || level == LogLevel::ERROR) {
+            fileStream_.flush();
+            IoStats::call(IoCall::WRITE, record.size());
+        }
+        fileSize_ += record.size();
+        rotateIfNeeded();
     }
 }
 
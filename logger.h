@@ -7,7 +7,13 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <initializer_list>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include "error_handler.h"
+#include "log_format.h"
+#include "log_archiver.h"
 
 enum class LogLevel {
     INFO,
@@ -16,15 +22,46 @@ enum class LogLevel {
     DEBUG
 };
 
+// Формат файла лога: текст или компактные бинарные записи (см. log_format.h),
+// которые переводятся в текст утилитой vcalc-logdump
+enum class LogOutput {
+    TEXT,
+    BINARY
+};
+
+// Прореживание сообщений по шаблону: состояние для каждого LogFormat
+struct LogLimiter {
+    std::atomic<uint64_t> seen{0};
+    std::atomic<int64_t> window{0};        // Текущая секунда для ограничения скорости
+    std::atomic<uint32_t> windowCount{0};  // Сообщений в текущей секунде
+    std::atomic<uint64_t> suppressed{0};   // Отброшено с последней сводки
+};
+
 class Logger {
 private:
     std::string logFile_;
     std::ofstream fileStream_;
     std::mutex logMutex_;
     bool enabled_;
+    LogOutput output_;
+    
+    // Прореживаются только INFO и DEBUG сообщения по шаблонам (logf)
+    uint32_t sampleEvery_;     // Писать каждое N-е сообщение шаблона (1 - все)
+    uint32_t ratePerSecond_;   // Не больше K сообщений шаблона в секунду (0 - без лимита)
+    LogLimiter limiters_[static_cast<size_t>(LogFormat::FORMAT_COUNT)];
+    std::atomic<int64_t> lastSummary_;
+    std::atomic<int> minSeverity_;  // Сообщения менее важные отбрасываются
+    
+    // Ротация: файл переименовывается под блокировкой записи, сжатие
+    // и удаление старых файлов выполняет archiver_ в своем потоке
+    uint64_t maxFileSize_;    // 0 - без ротации по размеру
+    int64_t maxFileAge_;      // Секунды, 0 - без ротации по времени
+    uint64_t fileSize_;
+    int64_t fileOpenedAt_;
+    std::unique_ptr<LogArchiver> archiver_;
     
 public:
-    Logger(const std::string& logFile);
+    Logger(const std::string& logFile, LogOutput output = LogOutput::TEXT);
     ~Logger();
     
     void log(LogLevel level, const std::string& message);
@@ -33,10 +70,38 @@ public:
     void error(const std::string& message);
     void debug(const std::string& message);
     
+    // Сообщение по шаблону: в бинарном режиме текст не собирается вовсе
+    void logf(LogLevel level, LogFormat format, std::initializer_list<LogArg> args = {});
+    
+    // Сбрасывает буфер файла на диск (например, перед fork())
+    void flush();
+    
+    void setSampling(uint32_t sampleEvery, uint32_t ratePerSecond);
+    
+    // Минимальный уровень: DEBUG пишет все, ERROR - только ошибки.
+    // Можно менять на лету из другого потока.
+    void setLevel(LogLevel level);
+    LogLevel getLevel() const;
+    static bool parseLevel(const std::string& name, LogLevel& level);
+    static std::string levelName(LogLevel level);
+    
+    // Включает ротацию по размеру и/или возрасту файла. keepFiles - сколько
+    // ротированных файлов хранить (0 - все), compress - сжимать их в gzip
+    void setRotation(uint64_t maxFileSize, int64_t maxFileAge, size_t keepFiles, bool compress);
+    
+    // Пишет сводку об отброшенных сообщениях. Без force - не чаще
+    // одного раза в LOG_SUMMARY_INTERVAL секунд
+    void reportSuppressed(bool force = false);
+    
 private:
     std::string getCurrentTime() const;
     std::string levelToString(LogLevel level) const;
     void ensureFileOpen();
+    void rotateIfNeeded();
+    static int severity(LogLevel level);
+    bool admit(LogLevel level, LogFormat format);
+    void writeText(LogLevel level, const std::string& message);
+    void writeBinary(LogLevel level, LogFormat format, const LogArg* args, size_t count);
 };
 
 #endif // LOGGER_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "memory_budget.h"
+
+MemoryBudget::Account::~Account() {
+    budget_.release(*this, used_.load());
+}
+
+MemoryBudget::MemoryBudget(uint64_t limit, uint64_t connectionLimit, std::chrono::milliseconds wait)
+    : limit_(limit),
+      connectionLimit_(connectionLimit),
+      wait_(wait),
+      used_(0),
+      peak_(0),
+      waits_(0),
+      rejected_(0),
+      waiters_(0) {}
+
+bool MemoryBudget::tryReserve(Account& account, uint64_t bytes) {
+    // Резервирует только поток сессии, остальные лишь освобождают,
+    // поэтому проверка счета соединения не устареет до прибавления
+    if (connectionLimit_ > 0 && account.used_.load() + bytes > connectionLimit_) {
+        return false;
+    }
+
+    uint64_t used = used_.load();
+    do {
+        if (limit_ > 0 && used + bytes > limit_) {
+            return false;
+        }
+    } while (!used_.compare_exchange_weak(used, used + bytes));
+    account.used_.fetch_add(bytes);
+
+    uint64_t peak = peak_.load(std::memory_order_relaxed);
+    while (used + bytes > peak &&
+           !peak_.compare_exchange_weak(peak, used + bytes, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+bool MemoryBudget::acquire(Account& account, uint64_t bytes) {
+    if (bytes == 0) {
+        return true;
+    }
+    // Запрос больше лимита не поместится никогда
+    if ((limit_ > 0 && bytes > limit_) || (connectionLimit_ > 0 && bytes > connectionLimit_)) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (tryReserve(account, bytes)) {
+        return true;
+    }
+
+    waits_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters_++;
+    bool reserved = released_.wait_for(lock, wait_, [&] { return tryReserve(account, bytes); });
+    waiters_--;
+    if (!reserved) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return reserved;
+}
+
+void MemoryBudget::release(Account& account, uint64_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    account.used_.fetch_sub(bytes);
+    returnBytes(bytes);
+}
+
+void MemoryBudget::returnBytes(uint64_t bytes) {
+    used_.fetch_sub(bytes);
+    // Ожидающий увеличивает waiters_ под мьютексом до проверки условия,
+    // поэтому уведомление после уменьшения used_ не теряется
+    if (waiters_.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_.notify_all();
+    }
+}
+
+MemoryBudget::Stats MemoryBudget::stats() const {
+    Stats stats;
+    stats.used = used_.load(std::memory_order_relaxed);
+    stats.peak = peak_.load(std::memory_order_relaxed);
+    stats.limit = limit_;
+    stats.connectionLimit = connectionLimit_;
+    stats.waits = waits_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    return stats;
+}
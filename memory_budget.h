@@ -0,0 +1,99 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Учет памяти под данные клиентов: векторы, буферы пакетов и кольца
+// в разделяемой памяти. Сессия резервирует байты до чтения данных из сокета.
+// Если общий бюджет процесса или бюджет соединения исчерпан, чтение
+// откладывается: данные ждут в буфере ядра, и TCP-окно клиента закрывается.
+// Если за время ожидания место не освободилось, запрос отклоняется.
+// Нулевой лимит - без ограничения, учет при этом все равно ведется.
+class MemoryBudget {
+public:
+    struct Stats {
+        uint64_t used;
+        uint64_t peak;
+        uint64_t limit;
+        uint64_t connectionLimit;
+        uint64_t waits;     // Резервирования, которым пришлось ждать
+        uint64_t rejected;  // Резервирования, которые не дождались места
+    };
+
+    // Счет одного соединения. Резервировать может один поток,
+    // а освобождать - любые (задачи пула в режиме с номерами запросов).
+    class Account {
+    private:
+        MemoryBudget& budget_;
+        std::atomic<uint64_t> used_;
+
+        friend class MemoryBudget;
+
+    public:
+        explicit Account(MemoryBudget& budget) : budget_(budget), used_(0) {}
+        // Возвращает в общий бюджет все, что не было освобождено
+        ~Account();
+
+        Account(const Account&) = delete;
+        Account& operator=(const Account&) = delete;
+
+        // Ждет места не дольше заданного в бюджете времени; false - запрос отклонен
+        bool acquire(uint64_t bytes) { return budget_.acquire(*this, bytes); }
+        void release(uint64_t bytes) { budget_.release(*this, bytes); }
+        uint64_t used() const { return used_.load(std::memory_order_relaxed); }
+    };
+
+    // Резерв на время жизни объекта
+    class Reservation {
+    private:
+        Account& account_;
+        uint64_t bytes_;
+        bool acquired_;
+
+    public:
+        Reservation(Account& account, uint64_t bytes)
+            : account_(account), bytes_(bytes), acquired_(account.acquire(bytes)) {}
+        ~Reservation() {
+            if (acquired_) {
+                account_.release(bytes_);
+            }
+        }
+
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+        explicit operator bool() const { return acquired_; }
+    };
+
+private:
+    uint64_t limit_;
+    uint64_t connectionLimit_;
+    std::chrono::milliseconds wait_;
+    std::atomic<uint64_t> used_;
+    std::atomic<uint64_t> peak_;
+    std::atomic<uint64_t> waits_;
+    std::atomic<uint64_t> rejected_;
+
+    // Только для ожидания: быстрый путь обходится атомарными операциями
+    std::mutex mutex_;
+    std::condition_variable released_;
+    std::atomic<int> waiters_;
+
+public:
+    MemoryBudget(uint64_t limit, uint64_t connectionLimit, std::chrono::milliseconds wait);
+
+    bool limited() const { return limit_ > 0 || connectionLimit_ > 0; }
+    Stats stats() const;
+
+private:
+    bool acquire(Account& account, uint64_t bytes);
+    void release(Account& account, uint64_t bytes);
+    bool tryReserve(Account& account, uint64_t bytes);
+    void returnBytes(uint64_t bytes);
+};
+
+#endif // MEMORY_BUDGET_H
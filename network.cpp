@@ -1,6 +1,15 @@
 #include "network.h"
+#include "io_stats.h"
 #include <iostream>
 #include <algorithm>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <poll.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <cstdlib>
 
 #ifndef le32toh
 #if __BYTE_ORDER == __LITTLE_ENDIAN
@@ -13,7 +22,8 @@
 #endif
 
 NetworkManager::NetworkManager(Logger& logger) 
-    : logger_(logger), serverSocket_(-1), initialized_(false) {}
+    : logger_(logger), serverSocket_(-1), unixSocket_(-1), udpSocket_(-1), handoffSocket_(-1),
+      handedOff_(false), initialized_(false) {}
 
 NetworkManager::~NetworkManager() {
     shutdown();
@@ -52,17 +62,424 @@ bool NetworkManager::initialize(uint16_t port) {
     return true;
 }
 
+bool NetworkManager::initializeUnix(const std::string& path) {
+    struct sockaddr_un addr;
+    if (path.empty() || path.length() >= sizeof(addr.sun_path)) {
+        logger_.error("Invalid Unix socket path: " + path);
+        return false;
+    }
+    
+    unixSocket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (unixSocket_ == -1) {
+        logger_.error("Failed to create Unix socket: " + std::string(strerror(errno)));
+        throw NetworkException("Cannot create Unix socket");
+    }
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    
+    // Удаляем файл сокета, оставшийся от предыдущего запуска
+    unlink(path.c_str());
+    
+    if (bind(unixSocket_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        logger_.error("Failed to bind Unix socket " + path + ": " + std::string(strerror(errno)));
+        close(unixSocket_);
+        unixSocket_ = -1;
+        throw NetworkException("Cannot bind to Unix socket " + path);
+    }
+    
+    if (listen(unixSocket_, tuning_.backlog) < 0) {
+        logger_.error("Failed to start listening on Unix socket: " + std::string(strerror(errno)));
+        close(unixSocket_);
+        unixSocket_ = -1;
+        unlink(path.c_str());
+        throw NetworkException("Cannot start listening on Unix socket");
+    }
+    
+    unixPath_ = path;
+    initialized_ = true;
+    logger_.info("Network manager listening on Unix socket " + path);
+    return true;
+}
+
+bool NetworkManager::initializeUdp(uint16_t port) {
+    udpSocket_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (udpSocket_ == -1) {
+        logger_.error("Failed to create UDP socket: " + std::string(strerror(errno)));
+        throw NetworkException("Cannot create UDP socket");
+    }
+    
+    // Пачки датаграмм копятся в очереди сокета между вызовами recvmmsg
+    int bufferSize = 4 * 1024 * 1024;
+    setsockopt(udpSocket_, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    
+    if (bind(udpSocket_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        logger_.error("Failed to bind UDP socket to port " + std::to_string(port) +
+                     ": " + std::string(strerror(errno)));
+        close(udpSocket_);
+        udpSocket_ = -1;
+        throw NetworkException("Cannot bind UDP port " + std::to_string(port));
+    }
+    
+    initialized_ = true;
+    logger_.info("Network manager listening for UDP datagrams on port " + std::to_string(port));
+    return true;
+}
+
 void NetworkManager::shutdown() {
     if (serverSocket_ != -1) {
         close(serverSocket_);
         serverSocket_ = -1;
         logger_.info("Network manager shutdown");
     }
+    if (unixSocket_ != -1) {
+        close(unixSocket_);
+        unixSocket_ = -1;
+        // После передачи сокета файл принадлежит новому процессу
+        if (!handedOff_) {
+            unlink(unixPath_.c_str());
+        }
+    }
+    if (udpSocket_ != -1) {
+        close(udpSocket_);
+        udpSocket_ = -1;
+    }
+    if (handoffSocket_ != -1) {
+        close(handoffSocket_);
+        handoffSocket_ = -1;
+    }
     initialized_ = false;
 }
 
+bool NetworkManager::waitReadable(int socket, int timeoutMs) {
+    struct pollfd pfd;
+    pfd.fd = socket;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    
+    int result;
+    do {
+        result = poll(&pfd, 1, timeoutMs);
+        IoStats::call(IoCall::POLL, 0);
+    } while (result < 0 && errno == EINTR);
+    
+    return result > 0;
+}
+
+bool NetworkManager::waitReadableWhileAlive(int socket, pid_t child, int timeoutMs) {
+    // Короткие интервалы: если exec не удался, потомок сразу завершается,
+    // и ждать все время ожидания незачем. WNOWAIT оставляет потомка
+    // вызывающему, который его и соберет.
+    const int sliceMs = 100;
+    for (int waited = 0; waited < timeoutMs; waited += sliceMs) {
+        if (waitReadable(socket, std::min(sliceMs, timeoutMs - waited))) {
+            return true;
+        }
+        siginfo_t info;
+        memset(&info, 0, sizeof(info));
+        if (waitid(P_PID, child, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == child) {
+            logger_.error("New server process " + std::to_string(child) + " exited with status " +
+                          std::to_string(info.si_status));
+            return false;
+        }
+    }
+    return false;
+}
+
+int NetworkManager::openHandoffChannel(const std::string& path) {
+    struct sockaddr_un addr;
+    if (path.empty() || path.length() >= sizeof(addr.sun_path)) {
+        logger_.error("Invalid handoff socket path: " + path);
+        return -1;
+    }
+    
+    int channel = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (channel == -1) {
+        logger_.error("Failed to create handoff socket: " + std::string(strerror(errno)));
+        return -1;
+    }
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    
+    // Канал отдает слушающие сокеты: подключиться к нему может только
+    // владелец процесса. umask действует на файл, который создает bind()
+    unlink(path.c_str());
+    mode_t previousMask = umask(0077);
+    int bound = bind(channel, (struct sockaddr*)&addr, sizeof(addr));
+    int bindErrno = errno;
+    umask(previousMask);
+    if (bound < 0 || listen(channel, 1) < 0) {
+        logger_.error("Failed to open handoff socket " + path + ": " +
+                      std::string(strerror(bound < 0 ? bindErrno : errno)));
+        close(channel);
+        return -1;
+    }
+    
+    logger_.info("Handoff channel opened: " + path);
+    return channel;
+}
+
+bool NetworkManager::handOffListeners(int channelSocket, const std::string& path, pid_t child) {
+    // Новый процесс должен подключиться и подтвердить готовность за 30 секунд
+    const int timeoutMs = 30000;
+    bool success = false;
+    int peer = -1;
+    
+    // Сокеты получает только запущенный нами процесс: остальные
+    // подключения закрываются, а ожидание продолжается
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (peer == -1) {
+        int remainingMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        if (remainingMs <= 0 || !waitReadableWhileAlive(channelSocket, child, remainingMs)) {
+            logger_.error("New server process did not connect to handoff channel");
+            break;
+        }
+        peer = accept4(channelSocket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (peer < 0) {
+            logger_.error("Failed to accept handoff connection: " + std::string(strerror(errno)));
+            break;
+        }
+        struct ucred cred;
+        memset(&cred, 0, sizeof(cred));
+        socklen_t credLength = sizeof(cred);
+        if (getsockopt(peer, SOL_SOCKET, SO_PEERCRED, &cred, &credLength) < 0 ||
+            cred.pid != child || cred.uid != geteuid()) {
+            logger_.warning("Rejected handoff connection from pid " + std::to_string(cred.pid) +
+                            ", expected " + std::to_string(child));
+            close(peer);
+            peer = -1;
+        }
+    }
+    
+    if (peer != -1) {
+        // Тип каждого передаваемого дескриптора: 'T' - TCP, 'U' - Unix, 'D' - UDP
+        char kinds[3];
+        int fds[3];
+        size_t fdCount = 0;
+        if (serverSocket_ != -1) {
+            kinds[fdCount] = 'T';
+            fds[fdCount++] = serverSocket_;
+        }
+        if (unixSocket_ != -1) {
+            kinds[fdCount] = 'U';
+            fds[fdCount++] = unixSocket_;
+        }
+        if (udpSocket_ != -1) {
+            kinds[fdCount] = 'D';
+            fds[fdCount++] = udpSocket_;
+        }
+        
+        struct iovec iov;
+        iov.iov_base = kinds;
+        iov.iov_len = fdCount;
+        
+        char control[CMSG_SPACE(sizeof(fds))];
+        memset(control, 0, sizeof(control));
+        
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(fdCount * sizeof(int));
+        msg.msg_controllen = CMSG_SPACE(fdCount * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, fdCount * sizeof(int));
+        
+        char ack = 0;
+        if (fdCount == 0) {
+            logger_.error("No listening sockets to hand off");
+        } else if (sendmsg(peer, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(fdCount)) {
+            logger_.error("Failed to send listening sockets: " + std::string(strerror(errno)));
+        } else if (!waitReadableWhileAlive(peer, child, timeoutMs) || recv(peer, &ack, 1, 0) != 1 ||
+                   ack != 'R') {
+            logger_.error("New server process did not confirm readiness");
+        } else {
+            success = true;
+            handedOff_ = true;
+            logger_.info("Listening sockets handed off to new server process");
+        }
+    }
+    
+    if (peer != -1) {
+        close(peer);
+    }
+    close(channelSocket);
+    unlink(path.c_str());
+    return success;
+}
+
+bool NetworkManager::adoptListeners(const std::string& path, const std::string& unixPath) {
+    if (initialized_) {
+        logger_.warning("Network manager already initialized");
+        return true;
+    }
+    
+    struct sockaddr_un addr;
+    if (path.length() >= sizeof(addr.sun_path)) {
+        logger_.error("Invalid handoff socket path: " + path);
+        return false;
+    }
+    
+    int channel = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (channel == -1) {
+        logger_.error("Failed to create handoff socket: " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    
+    if (connect(channel, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        logger_.error("Failed to connect to handoff channel " + path + ": " + std::string(strerror(errno)));
+        close(channel);
+        return false;
+    }
+    
+    char kinds[4] = {0};
+    int fds[4];
+    
+    struct iovec iov;
+    iov.iov_base = kinds;
+    iov.iov_len = sizeof(kinds);
+    
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+    
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    
+    ssize_t received = recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (received <= 0 || cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS) {
+        logger_.error("Failed to receive listening sockets from previous server process");
+        close(channel);
+        return false;
+    }
+    
+    size_t fdCount = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(fds, CMSG_DATA(cmsg), fdCount * sizeof(int));
+    
+    for (size_t i = 0; i < fdCount; ++i) {
+        if (i < static_cast<size_t>(received) && kinds[i] == 'T' && serverSocket_ == -1) {
+            serverSocket_ = fds[i];
+        } else if (i < static_cast<size_t>(received) && kinds[i] == 'U' && unixSocket_ == -1 &&
+                   !unixPath.empty()) {
+            unixSocket_ = fds[i];
+            unixPath_ = unixPath;
+        } else if (i < static_cast<size_t>(received) && kinds[i] == 'D' && udpSocket_ == -1) {
+            udpSocket_ = fds[i];
+        } else {
+            close(fds[i]);
+        }
+    }
+    
+    if (serverSocket_ == -1 && unixSocket_ == -1 && udpSocket_ == -1) {
+        logger_.error("Handoff did not include any listening socket");
+        close(channel);
+        return false;
+    }
+    
+    handoffSocket_ = channel;
+    initialized_ = true;
+    logger_.info("Adopted listening sockets from previous server process");
+    return true;
+}
+
+bool NetworkManager::socketActivationRequested() {
+    const char* pid = std::getenv("LISTEN_PID");
+    const char* fds = std::getenv("LISTEN_FDS");
+    // Переменные наследуются дочерними процессами, поэтому проверяется PID
+    return pid != nullptr && fds != nullptr && std::strtol(pid, nullptr, 10) == getpid();
+}
+
+bool NetworkManager::adoptActivatedSockets() {
+    if (initialized_) {
+        logger_.warning("Network manager already initialized");
+        return true;
+    }
+    
+    long count = std::strtol(std::getenv("LISTEN_FDS"), nullptr, 10);
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_FDNAMES");
+    if (count <= 0 || count > 64) {
+        logger_.error("Invalid LISTEN_FDS value: " + std::to_string(count));
+        return false;
+    }
+    
+    for (int fd = LISTEN_FDS_START; fd < LISTEN_FDS_START + count; ++fd) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        
+        int type = 0;
+        int domain = 0;
+        int listening = 0;
+        socklen_t length = sizeof(type);
+        bool known = getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length) == 0;
+        length = sizeof(domain);
+        known = known && getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &length) == 0;
+        length = sizeof(listening);
+        known = known && getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &length) == 0;
+        
+        if (known && type == SOCK_STREAM && listening && domain == AF_UNIX && unixSocket_ == -1) {
+            // Файл сокета принадлежит менеджеру служб: unixPath_ пуст, и он не удаляется
+            unixSocket_ = fd;
+        } else if (known && type == SOCK_STREAM && listening && domain != AF_UNIX && serverSocket_ == -1) {
+            serverSocket_ = fd;
+        } else if (known && type == SOCK_DGRAM && domain == AF_INET && udpSocket_ == -1) {
+            // UDP-режим хранит адреса клиентов в sockaddr_in: только IPv4
+            udpSocket_ = fd;
+        } else {
+            logger_.warning("Ignoring unsupported inherited socket " + std::to_string(fd));
+            close(fd);
+        }
+    }
+    
+    if (serverSocket_ == -1 && unixSocket_ == -1 && udpSocket_ == -1) {
+        logger_.error("Socket activation did not pass any usable socket");
+        return false;
+    }
+    
+    initialized_ = true;
+    logger_.info("Adopted " + std::to_string(count) + " sockets from the service manager");
+    return true;
+}
+
+void NetworkManager::confirmHandoff() {
+    if (handoffSocket_ == -1) {
+        return;
+    }
+    
+    char ack = 'R';
+    if (send(handoffSocket_, &ack, 1, MSG_NOSIGNAL) != 1) {
+        logger_.warning("Failed to confirm handoff: " + std::string(strerror(errno)));
+    }
+    close(handoffSocket_);
+    handoffSocket_ = -1;
+}
+
 bool NetworkManager::createSocket() {
-    serverSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+    serverSocket_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (serverSocket_ == -1) {
         logger_.error("Failed to create socket: " + std::string(strerror(errno)));
         throw NetworkException("Cannot create socket");
@@ -76,9 +493,43 @@ bool NetworkManager::setSocketOptions() {
         logger_.error("Failed to set socket options: " + std::string(strerror(errno)));
         return false;
     }
+    
+    // Размеры буферов задаются до listen(): от них зависит масштаб окна,
+    // а принятые сокеты наследуют их от слушающего
+    if (tuning_.receiveBuffer > 0 &&
+        setsockopt(serverSocket_, SOL_SOCKET, SO_RCVBUF, &tuning_.receiveBuffer, sizeof(int)) < 0) {
+        logger_.warning("Failed to set SO_RCVBUF: " + std::string(strerror(errno)));
+    }
+    if (tuning_.sendBuffer > 0 &&
+        setsockopt(serverSocket_, SOL_SOCKET, SO_SNDBUF, &tuning_.sendBuffer, sizeof(int)) < 0) {
+        logger_.warning("Failed to set SO_SNDBUF: " + std::string(strerror(errno)));
+    }
+    if (tuning_.deferAcceptSeconds > 0 &&
+        setsockopt(serverSocket_, IPPROTO_TCP, TCP_DEFER_ACCEPT, &tuning_.deferAcceptSeconds, sizeof(int)) < 0) {
+        logger_.warning("Failed to set TCP_DEFER_ACCEPT: " + std::string(strerror(errno)));
+    }
+    if (tuning_.fastOpenQueue > 0 &&
+        setsockopt(serverSocket_, IPPROTO_TCP, TCP_FASTOPEN, &tuning_.fastOpenQueue, sizeof(int)) < 0) {
+        logger_.warning("Failed to enable TCP_FASTOPEN: " + std::string(strerror(errno)));
+    }
     return true;
 }
 
+void NetworkManager::tuneClientSocket(int clientSocket) {
+    int opt = 1;
+    if (tuning_.noDelay) {
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    }
+    if (tuning_.quickAck) {
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+    }
+    // Без CAP_NET_ADMIN ядро не дает поднять значение выше net.core.busy_read
+    if (tuning_.busyPollMicros > 0 &&
+        setsockopt(clientSocket, SOL_SOCKET, SO_BUSY_POLL, &tuning_.busyPollMicros, sizeof(int)) < 0) {
+        logger_.warning("Failed to set SO_BUSY_POLL: " + std::string(strerror(errno)));
+    }
+}
+
 bool NetworkManager::bindSocket(uint16_t port) {
     struct sockaddr_in serverAddr;
     memset(&serverAddr, 0, sizeof(serverAddr));
@@ -96,7 +547,7 @@ bool NetworkManager::bindSocket(uint16_t port) {
 }
 
 bool NetworkManager::startListening() {
-    if (listen(serverSocket_, 10) < 0) {
+    if (listen(serverSocket_, tuning_.backlog) < 0) {
         logger_.error("Failed to start listening: " + std::string(strerror(errno)));
         throw NetworkException("Cannot start listening");
     }
@@ -104,12 +555,20 @@ bool NetworkManager::startListening() {
 }
 
 int NetworkManager::acceptClient(std::string& clientIP) {
-    struct sockaddr_in clientAddr;
+    return acceptClient(serverSocket_, clientIP);
+}
+
+int NetworkManager::acceptClient(int listenSocket, std::string& clientIP) {
+    struct sockaddr_storage clientAddr;
     socklen_t clientLen = sizeof(clientAddr);
     
-    int clientSocket = accept(serverSocket_, (struct sockaddr*)&clientAddr, &clientLen);
+    int clientSocket = accept4(listenSocket, (struct sockaddr*)&clientAddr, &clientLen, SOCK_CLOEXEC);
     if (clientSocket < 0) {
-        logger_.error("Failed to accept client connection: " + std::string(strerror(errno)));
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            int savedErrno = errno;
+            logger_.error("Failed to accept client connection: " + std::string(strerror(errno)));
+            errno = savedErrno;
+        }
         return -1;
     }
     
@@ -119,14 +578,41 @@ int NetworkManager::acceptClient(std::string& clientIP) {
     timeout.tv_usec = 0;
     setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
     
-    char ipBuffer[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &clientAddr.sin_addr, ipBuffer, INET_ADDRSTRLEN);
-    clientIP = ipBuffer;
+    if (clientAddr.ss_family == AF_UNIX) {
+        // Локальный клиент идентифицируется по PID процесса
+        struct ucred cred;
+        socklen_t credLen = sizeof(cred);
+        if (getsockopt(clientSocket, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) == 0) {
+            clientIP = "unix:pid=" + std::to_string(cred.pid);
+        } else {
+            clientIP = "unix";
+        }
+    } else if (clientAddr.ss_family == AF_INET6) {
+        tuneClientSocket(clientSocket);
+        // Сокет от systemd обычно слушает [::] и принимает и IPv4-клиентов
+        char ipBuffer[INET6_ADDRSTRLEN];
+        inet_ntop(AF_INET6, &((struct sockaddr_in6*)&clientAddr)->sin6_addr, ipBuffer, INET6_ADDRSTRLEN);
+        clientIP = ipBuffer;
+    } else {
+        tuneClientSocket(clientSocket);
+        char ipBuffer[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &((struct sockaddr_in*)&clientAddr)->sin_addr, ipBuffer, INET_ADDRSTRLEN);
+        clientIP = ipBuffer;
+    }
     
-    logger_.info("Client connected from: " + clientIP);
+    logger_.logf(LogLevel::INFO, LogFormat::CLIENT_CONNECTED, {clientIP});
     return clientSocket;
 }
 
+void NetworkManager::setListenersNonBlocking() {
+    for (int listenSocket : {serverSocket_, unixSocket_}) {
+        if (listenSocket != -1) {
+            int flags = fcntl(listenSocket, F_GETFL, 0);
+            fcntl(listenSocket, F_SETFL, flags | O_NONBLOCK);
+        }
+    }
+}
+
 void NetworkManager::closeClient(int clientSocket) {
     if (clientSocket != -1) {
         close(clientSocket);
@@ -136,8 +622,9 @@ void NetworkManager::closeClient(int clientSocket) {
 bool NetworkManager::receiveLogin(int clientSocket, std::string& login) {
     char buffer[256] = {0};
     
-    logger_.debug("Waiting for login...");
+    logger_.logf(LogLevel::DEBUG, LogFormat::WAITING_LOGIN);
     ssize_t bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
+    IoStats::call(IoCall::RECV, bytesReceived);
     
     if (bytesReceived <= 0) {
         if (bytesReceived == 0) {
@@ -149,19 +636,26 @@ bool NetworkManager::receiveLogin(int clientSocket, std::string& login) {
     }
     
     login.assign(buffer, bytesReceived);
-    logger_.debug("Received login: " + login);
+    logger_.logf(LogLevel::DEBUG, LogFormat::RECEIVED_LOGIN, {login});
     return true;
 }
 
+ssize_t NetworkManager::receiveSome(int clientSocket, void* buffer, size_t size) {
+    ssize_t bytesReceived = recv(clientSocket, buffer, size, 0);
+    IoStats::call(IoCall::RECV, bytesReceived);
+    return bytesReceived;
+}
+
 bool NetworkManager::receiveData(int clientSocket, void* buffer, size_t size) {
     size_t totalReceived = 0;
     char* data = static_cast<char*>(buffer);
     
-    logger_.debug("Waiting for " + std::to_string(size) + " bytes...");
+    logger_.logf(LogLevel::DEBUG, LogFormat::WAITING_BYTES, {size});
     
     while (totalReceived < size) {
         ssize_t bytesReceived = recv(clientSocket, data + totalReceived, 
                                    size - totalReceived, 0);
+        IoStats::call(IoCall::RECV, bytesReceived);
         
         if (bytesReceived <= 0) {
             if (bytesReceived == 0) {
@@ -179,10 +673,17 @@ bool NetworkManager::receiveData(int clientSocket, void* buffer, size_t size) {
         totalReceived += bytesReceived;
     }
     
-    logger_.debug("Successfully received " + std::to_string(totalReceived) + " bytes");
+    logger_.logf(LogLevel::DEBUG, LogFormat::RECEIVED_BYTES, {totalReceived});
     return true;
 }
 
+bool NetworkManager::rearmQuickAck(int clientSocket) {
+    int opt = 1;
+    int result = setsockopt(clientSocket, IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+    IoStats::call(IoCall::SOCKOPT, 0);
+    return result == 0;
+}
+
 bool NetworkManager::sendData(int clientSocket, const void* data, size_t size) {
     const char* byteData = static_cast<const char*>(data);
     size_t totalSent = 0;
@@ -190,6 +691,7 @@ bool NetworkManager::sendData(int clientSocket, const void* data, size_t size) {
     while (totalSent < size) {
         ssize_t bytesSent = send(clientSocket, byteData + totalSent, 
                                size - totalSent, 0);
+        IoStats::call(IoCall::SEND, bytesSent);
         if (bytesSent <= 0) {
             logger_.error("Failed to send data to client: " + std::string(strerror(errno)));
             return false;
@@ -199,3 +701,52 @@ bool NetworkManager::sendData(int clientSocket, const void* data, size_t size) {
     
     return true;
 }
+
+
+bool NetworkManager::isLocalConnection(int clientSocket) const {
+    int domain = 0;
+    socklen_t length = sizeof(domain);
+    if (getsockopt(clientSocket, SOL_SOCKET, SO_DOMAIN, &domain, &length) < 0) {
+        return false;
+    }
+    return domain == AF_UNIX;
+}
+
+bool NetworkManager::sendDescriptors(int clientSocket, const void* data, size_t size,
+                                     const std::vector<int>& fds) {
+    struct iovec iov;
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = size;
+    
+    std::vector<char> control(CMSG_SPACE(fds.size() * sizeof(int)), 0);
+    
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fds.size() * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds.data(), fds.size() * sizeof(int));
+    
+    ssize_t bytesSent = sendmsg(clientSocket, &msg, MSG_NOSIGNAL);
+    IoStats::call(IoCall::SEND, bytesSent);
+    if (bytesSent != static_cast<ssize_t>(size)) {
+        logger_.error("Failed to send descriptors to client: " + std::string(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+int NetworkManager::getIncomingCpu(int clientSocket) const {
+    int cpu = -1;
+    socklen_t length = sizeof(cpu);
+    if (getsockopt(clientSocket, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &length) < 0) {
+        return -1;
+    }
+    return cpu;
+}
\ No newline at end of file
@@ -12,37 +12,96 @@
 #include <algorithm>
 #include "logger.h"
 #include "error_handler.h"
+#include "transport.h"
 
-class NetworkManager {
+// Настройки TCP для слушающего и принятых сокетов (0/false - как в системе)
+struct TcpTuning {
+    int backlog = 10;            // Очередь listen() для TCP и Unix-сокета
+    bool noDelay = false;        // TCP_NODELAY: ответы по 4 байта уходят без ожидания
+    bool quickAck = false;       // TCP_QUICKACK: подтверждение без задержки, взводится перед каждым запросом
+    int deferAcceptSeconds = 0;  // TCP_DEFER_ACCEPT: accept() только после прихода логина
+    int fastOpenQueue = 0;       // TCP_FASTOPEN: данные в SYN, длина очереди
+    int receiveBuffer = 0;       // SO_RCVBUF, байты
+    int sendBuffer = 0;          // SO_SNDBUF, байты
+    int busyPollMicros = 0;      // SO_BUSY_POLL: активное ожидание пакетов в recv()
+};
+
+// Первый дескриптор, передаваемый при активации через сокеты
+static const int LISTEN_FDS_START = 3;
+
+class NetworkManager : public Transport {
 private:
     Logger& logger_;
     int serverSocket_;
+    int unixSocket_;
+    std::string unixPath_;
+    int udpSocket_;
+    int handoffSocket_;
+    bool handedOff_;
     bool initialized_;
+    TcpTuning tuning_;
     
 public:
     NetworkManager(Logger& logger);
     ~NetworkManager();
     
+    // Применяется к сокетам, созданным и принятым после вызова
+    void setTcpTuning(const TcpTuning& tuning) { tuning_ = tuning; }
+    
     bool initialize(uint16_t port);
+    bool initializeUnix(const std::string& path);
+    bool initializeUdp(uint16_t port);
     void shutdown();
+    
+    // Передача слушающих сокетов новому процессу (горячий перезапуск)
+    int openHandoffChannel(const std::string& path);
+    // child - запущенный новый процесс: если он завершится, передача прерывается сразу
+    bool handOffListeners(int channelSocket, const std::string& path, pid_t child);
+    bool adoptListeners(const std::string& path, const std::string& unixPath);
+    void confirmHandoff();
+    
+    // Активация через сокеты (systemd): слушающие сокеты уже открыты
+    // менеджером служб и переданы начиная с дескриптора 3 (LISTEN_FDS)
+    static bool socketActivationRequested();
+    bool adoptActivatedSockets();
     int acceptClient(std::string& clientIP);
-    void closeClient(int clientSocket);
+    int acceptClient(int listenSocket, std::string& clientIP);
+    void closeClient(int clientSocket) override;
     
     // Методы для работы с клиентом
-    bool receiveLogin(int clientSocket, std::string& login);
+    bool receiveLogin(int clientSocket, std::string& login) override;
     
     // Публичные методы для доступа к базовым операциям
-    bool receiveData(int clientSocket, void* buffer, size_t size);
-    bool sendData(int clientSocket, const void* data, size_t size);
+    ssize_t receiveSome(int clientSocket, void* buffer, size_t size) override;
+    bool receiveData(int clientSocket, void* buffer, size_t size) override;
+    bool sendData(int clientSocket, const void* data, size_t size) override;
+    // Ядро сбрасывает TCP_QUICKACK после нескольких подтверждений; сервер
+    // взводит его заново перед заголовком каждого запроса TCP-клиента
+    bool rearmQuickAck(int clientSocket);
+    
+    // Процессор, на котором ядро обработало последние пакеты соединения (RSS)
+    int getIncomingCpu(int clientSocket) const;
+    
+    // Передача дескрипторов локальному клиенту (только для Unix-сокетов)
+    bool isLocalConnection(int clientSocket) const;
+    
+    // Для нескольких процессов на одних слушающих сокетах: accept() без ожидания
+    void setListenersNonBlocking();
+    bool sendDescriptors(int clientSocket, const void* data, size_t size, const std::vector<int>& fds);
     
     // Метод для получения серверного сокета (для select)
     int getServerSocket() const { return serverSocket_; }
+    int getUnixSocket() const { return unixSocket_; }
+    int getUdpSocket() const { return udpSocket_; }
     
 private:
     bool createSocket();
     bool bindSocket(uint16_t port);
     bool startListening();
     bool setSocketOptions();
+    void tuneClientSocket(int clientSocket);
+    bool waitReadable(int socket, int timeoutMs);
+    bool waitReadableWhileAlive(int socket, pid_t child, int timeoutMs);
 };
 
 #endif // NETWORK_H
\ No newline at end of file
@@ -0,0 +1,428 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <fstream>
+#include <link.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/prctl.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+static const size_t MAX_FRAMES = 64;
+static const size_t SAMPLE_CAPACITY = 4096;
+// Кадры дальше этого расстояния от вершины стека считаются мусором
+static const uintptr_t STACK_SCAN_LIMIT = 8 << 20;
+static const std::chrono::milliseconds COLLECT_INTERVAL(250);
+
+struct RawSample {
+    char thread[16];
+    uint32_t depth;
+    uintptr_t frames[MAX_FRAMES];
+};
+
+// Буфер обработчика сигнала. Флаг занят, пока буфер пишет обработчик или
+// забирает сборщик; обработчик не ждет флага, а выбрасывает выборку
+static RawSample g_samples[SAMPLE_CAPACITY];
+static size_t g_sampleCount = 0;
+static std::atomic_flag g_busy = ATOMIC_FLAG_INIT;
+static std::atomic<uint64_t> g_dropped(0);
+static std::atomic<SamplingProfiler*> g_active(nullptr);
+
+// Копия буфера для сборщика: буфер обработчика занят только на время memcpy
+static RawSample g_batch[SAMPLE_CAPACITY];
+static std::mutex g_batchMutex;
+
+// Чтение чужого кадра через ядро: указатель кадра в коде без -fno-omit-frame-pointer
+// (libc) может указывать куда угодно, и обычное чтение уронило бы процесс
+static bool readFrame(uintptr_t address, uintptr_t frame[2]) {
+    struct iovec local = {frame, 2 * sizeof(uintptr_t)};
+    struct iovec remote = {reinterpret_cast<void*>(address), 2 * sizeof(uintptr_t)};
+    return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) ==
+           static_cast<ssize_t>(2 * sizeof(uintptr_t));
+}
+
+static void profileSignalHandler(int, siginfo_t*, void* context) {
+    int savedErrno = errno;
+    const ucontext_t* uc = static_cast<const ucontext_t*>(context);
+    uintptr_t pc = 0;
+    uintptr_t fp = 0;
+    uintptr_t sp = 0;
+#if defined(__x86_64__)
+    pc = uc->uc_mcontext.gregs[REG_RIP];
+    fp = uc->uc_mcontext.gregs[REG_RBP];
+    sp = uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+    pc = uc->uc_mcontext.pc;
+    fp = uc->uc_mcontext.regs[29];
+    sp = uc->uc_mcontext.sp;
+#else
+    (void)uc;
+#endif
+
+    if (g_busy.test_and_set(std::memory_order_acquire)) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        errno = savedErrno;
+        return;
+    }
+    if (g_sampleCount == SAMPLE_CAPACITY || pc == 0) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        g_busy.clear(std::memory_order_release);
+        errno = savedErrno;
+        return;
+    }
+
+    RawSample& sample = g_samples[g_sampleCount];
+    memset(sample.thread, 0, sizeof(sample.thread));
+    prctl(PR_GET_NAME, sample.thread);
+    uint32_t depth = 0;
+    sample.frames[depth++] = pc;
+
+    // Запись кадра: [указатель кадра вызвавшей функции][адрес возврата].
+    // Стек растет вниз, поэтому каждый следующий кадр выше предыдущего
+    while (depth < MAX_FRAMES && fp >= sp && fp - sp < STACK_SCAN_LIMIT &&
+           fp % sizeof(uintptr_t) == 0) {
+        uintptr_t frame[2];
+        if (!readFrame(fp, frame) || frame[1] == 0) {
+            break;
+        }
+        sample.frames[depth++] = frame[1];
+        if (frame[0] <= fp) {
+            break;
+        }
+        fp = frame[0];
+    }
+    sample.depth = depth;
+    g_sampleCount++;
+
+    g_busy.clear(std::memory_order_release);
+    errno = savedErrno;
+}
+
+namespace {
+
+// "ns::Class::method(int, char) const" -> "ns::Class::method"
+std::string stripParameters(const std::string& name) {
+    static const std::string anonymous = "(anonymous namespace)";
+    int depth = 0;
+    for (size_t i = 0; i < name.size(); ++i) {
+        char c = name[i];
+        if (c == '<') {
+            depth++;
+        } else if (c == '>' && depth > 0) {
+            depth--;
+        } else if (c == '(' && depth == 0) {
+            if (name.compare(i, anonymous.size(), anonymous) == 0) {
+                i += anonymous.size() - 1;
+            } else if (i >= 8 && name.compare(i - 8, 8, "operator") == 0 &&
+                       name.compare(i, 2, "()") == 0) {
+                i++;
+            } else {
+                return name.substr(0, i);
+            }
+        }
+    }
+    return name;
+}
+
+std::string demangle(const char* symbol) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(symbol, nullptr, nullptr, &status);
+    std::string name = status == 0 && demangled ? stripParameters(demangled) : symbol;
+    free(demangled);
+    // ';' разделяет кадры в свернутом формате
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+}
+
+int findExecutableBase(struct dl_phdr_info* info, size_t, void* data) {
+    // Первым всегда идет сам исполняемый файл
+    *static_cast<uintptr_t*>(data) = info->dlpi_addr;
+    return 1;
+}
+
+// Имена функций берутся из .symtab исполняемого файла: в динамической таблице
+// символов есть только экспортируемые функции. Адреса библиотек - через dladdr.
+class Symbolizer {
+public:
+    Symbolizer() {
+        loadExecutable();
+    }
+
+    // Пустая строка - адрес не принадлежит ни одному загруженному файлу
+    const std::string& name(uintptr_t address) {
+        auto cached = cache_.find(address);
+        if (cached != cache_.end()) {
+            return cached->second;
+        }
+        return cache_[address] = lookup(address);
+    }
+
+private:
+    struct Symbol {
+        uintptr_t start;
+        uintptr_t size;
+        std::string name;
+
+        bool operator<(const Symbol& other) const {
+            return start < other.start;
+        }
+    };
+
+    std::vector<Symbol> symbols_;
+    std::map<uintptr_t, std::string> cache_;
+
+    void loadExecutable() {
+        std::ifstream file("/proc/self/exe", std::ios::binary);
+        std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (image.size() < sizeof(Elf64_Ehdr) || memcmp(image.data(), ELFMAG, SELFMAG) != 0 ||
+            image[EI_CLASS] != ELFCLASS64) {
+            return;
+        }
+
+        uintptr_t base = 0;
+        dl_iterate_phdr(findExecutableBase, &base);
+
+        const char* data = image.data();
+        const Elf64_Ehdr* header = reinterpret_cast<const Elf64_Ehdr*>(data);
+        if (header->e_shoff + static_cast<uint64_t>(header->e_shnum) * sizeof(Elf64_Shdr) > image.size()) {
+            return;
+        }
+        const Elf64_Shdr* sections = reinterpret_cast<const Elf64_Shdr*>(data + header->e_shoff);
+
+        for (int i = 0; i < header->e_shnum; ++i) {
+            const Elf64_Shdr& table = sections[i];
+            if (table.sh_type != SHT_SYMTAB || table.sh_link >= header->e_shnum) {
+                continue;
+            }
+            const Elf64_Shdr& strings = sections[table.sh_link];
+            if (table.sh_offset + table.sh_size > image.size() ||
+                strings.sh_offset + strings.sh_size > image.size()) {
+                continue;
+            }
+
+            const Elf64_Sym* symbols = reinterpret_cast<const Elf64_Sym*>(data + table.sh_offset);
+            size_t count = table.sh_size / sizeof(Elf64_Sym);
+            for (size_t j = 0; j < count; ++j) {
+                const Elf64_Sym& symbol = symbols[j];
+                if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_value == 0 ||
+                    symbol.st_name >= strings.sh_size) {
+                    continue;
+                }
+                symbols_.push_back({base + symbol.st_value, symbol.st_size,
+                                    demangle(data + strings.sh_offset + symbol.st_name)});
+            }
+        }
+        std::sort(symbols_.begin(), symbols_.end());
+    }
+
+    std::string lookup(uintptr_t address) {
+        Symbol probe = {address, 0, std::string()};
+        auto next = std::upper_bound(symbols_.begin(), symbols_.end(), probe);
+        if (next != symbols_.begin()) {
+            const Symbol& symbol = *(next - 1);
+            if (address < symbol.start + std::max<uintptr_t>(symbol.size, 1)) {
+                return symbol.name;
+            }
+        }
+
+        Dl_info info;
+        if (dladdr(reinterpret_cast<void*>(address), &info) != 0) {
+            if (info.dli_sname) {
+                return demangle(info.dli_sname);
+            }
+            if (info.dli_fname) {
+                const char* slash = strrchr(info.dli_fname, '/');
+                return std::string("[") + (slash ? slash + 1 : info.dli_fname) + "]";
+            }
+        }
+
+        return std::string();
+    }
+};
+
+} // namespace
+
+SamplingProfiler::SamplingProfiler() : running_(false), hz_(DEFAULT_HZ), total_(0) {}
+
+SamplingProfiler::~SamplingProfiler() {
+    stop();
+}
+
+bool SamplingProfiler::start(int hz) {
+    if (hz < 1 || hz > 1000) {
+        return false;
+    }
+    SamplingProfiler* expected = nullptr;
+    if (!g_active.compare_exchange_strong(expected, this)) {
+        return false;
+    }
+
+    // SA_RESTART: сигнал приходит в любой поток, и его блокирующие
+    // вызовы не должны заканчиваться EINTR
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = profileSignalHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+        g_active.store(nullptr);
+        return false;
+    }
+
+    // tv_usec обязан быть меньше секунды: при 1 Гц период - ровно 1 с.
+    // Таймер взводится до запуска сборщика, чтобы при ошибке откатывать
+    // только обработчик сигнала; ранние выборки дождутся первого сбора.
+    long periodUs = 1000000L / hz;
+    struct itimerval timer;
+    timer.it_interval.tv_sec = periodUs / 1000000;
+    timer.it_interval.tv_usec = periodUs % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        signal(SIGPROF, SIG_IGN);
+        g_active.store(nullptr);
+        return false;
+    }
+
+    hz_ = hz;
+    running_ = true;
+    collector_ = std::thread(&SamplingProfiler::collectLoop, this);
+    return true;
+}
+
+void SamplingProfiler::stop() {
+    if (!running_) {
+        return;
+    }
+
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    // Действие по умолчанию для SIGPROF - завершение процесса,
+    // а сигнал от таймера мог уже ждать доставки
+    signal(SIGPROF, SIG_IGN);
+
+    {
+        std::lock_guard<std::mutex> lock(collectorMutex_);
+        running_ = false;
+    }
+    collectorWake_.notify_all();
+    collector_.join();
+    collect();
+    g_active.store(nullptr);
+}
+
+void SamplingProfiler::reset() {
+    collect();
+    std::lock_guard<std::mutex> lock(stacksMutex_);
+    stacks_.clear();
+    total_ = 0;
+    g_dropped.store(0);
+}
+
+void SamplingProfiler::collectLoop() {
+    std::unique_lock<std::mutex> lock(collectorMutex_);
+    while (running_) {
+        collectorWake_.wait_for(lock, COLLECT_INTERVAL, [this] { return !running_; });
+        lock.unlock();
+        collect();
+        lock.lock();
+    }
+}
+
+void SamplingProfiler::collect() {
+    std::lock_guard<std::mutex> batchLock(g_batchMutex);
+    while (g_busy.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    size_t count = g_sampleCount;
+    memcpy(g_batch, g_samples, count * sizeof(RawSample));
+    g_sampleCount = 0;
+    g_busy.clear(std::memory_order_release);
+
+    if (count == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(stacksMutex_);
+    for (size_t i = 0; i < count; ++i) {
+        const RawSample& sample = g_batch[i];
+        StackKey key;
+        key.thread.assign(sample.thread, strnlen(sample.thread, sizeof(sample.thread)));
+        key.frames.assign(sample.frames, sample.frames + sample.depth);
+        stacks_[key]++;
+    }
+    total_ += count;
+}
+
+std::string SamplingProfiler::folded() {
+    collect();
+
+    // Разные адреса внутри одной функции дают одинаковые строки - их складываем
+    std::map<std::string, uint64_t> lines;
+    {
+        Symbolizer symbolizer;
+        std::lock_guard<std::mutex> lock(stacksMutex_);
+        for (const auto& entry : stacks_) {
+            const StackKey& key = entry.first;
+            std::vector<const std::string*> names;
+            for (size_t i = 0; i < key.frames.size(); ++i) {
+                // Адрес возврата указывает на инструкцию после вызова
+                const std::string& name = symbolizer.name(i == 0 ? key.frames[i] : key.frames[i] - 1);
+                // Библиотеки собраны без указателей кадров: после них цепочка - мусор
+                if (name.empty()) {
+                    break;
+                }
+                names.push_back(&name);
+            }
+
+            std::string line = key.thread.empty() ? "[unknown]" : key.thread;
+            if (names.empty()) {
+                line += ";[unknown]";
+            }
+            for (auto name = names.rbegin(); name != names.rend(); ++name) {
+                line += ";";
+                line += **name;
+            }
+            lines[line] += entry.second;
+        }
+    }
+
+    std::ostringstream out;
+    for (const auto& line : lines) {
+        out << line.first << " " << line.second << "\n";
+    }
+    return out.str();
+}
+
+bool SamplingProfiler::dump(const std::string& path) {
+    std::string text = folded();
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file << text;
+        if (!file.flush()) {
+            return false;
+        }
+    }
+    return rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+uint64_t SamplingProfiler::samples() {
+    collect();
+    std::lock_guard<std::mutex> lock(stacksMutex_);
+    return total_;
+}
+
+uint64_t SamplingProfiler::dropped() const {
+    return g_dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,68 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Встроенный выборочный профилировщик. Таймер ITIMER_PROF присылает SIGPROF
+// потоку, который тратит процессор; обработчик проходит по цепочке указателей
+// кадров (сборка с -fno-omit-frame-pointer) и кладет стек в буфер без
+// выделения памяти. Фоновый поток несколько раз в секунду переносит стеки
+// в общую таблицу. Результат - свернутые стеки "поток;функция;...;функция число",
+// вход для flamegraph.pl. Стеки потоков с одним именем складываются вместе.
+// SIGPROF и таймер одни на процесс, поэтому запущен может быть один профилировщик.
+class SamplingProfiler {
+public:
+    static const int DEFAULT_HZ = 99;
+
+    SamplingProfiler();
+    ~SamplingProfiler();
+
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    // false - частота вне диапазона 1-1000 или профилировщик уже запущен
+    bool start(int hz);
+    void stop();
+    bool running() const { return running_; }
+    int hz() const { return hz_; }
+    void reset();
+
+    std::string folded();
+    // Перезаписывает файл целиком (через временный файл)
+    bool dump(const std::string& path);
+
+    uint64_t samples();
+    uint64_t dropped() const;
+
+private:
+    struct StackKey {
+        std::string thread;
+        std::vector<uintptr_t> frames;  // От вызванной функции к вызвавшим
+
+        bool operator<(const StackKey& other) const {
+            return thread != other.thread ? thread < other.thread : frames < other.frames;
+        }
+    };
+
+    std::atomic<bool> running_;
+    int hz_;
+    std::thread collector_;
+    std::mutex collectorMutex_;
+    std::condition_variable collectorWake_;
+
+    std::mutex stacksMutex_;
+    std::map<StackKey, uint64_t> stacks_;
+    uint64_t total_;
+
+    void collectLoop();
+    void collect();
+};
+
+#endif // PROFILER_H
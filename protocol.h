@@ -0,0 +1,101 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Ограничения классического протокола (v1)
+constexpr uint32_t MAX_VECTORS_PER_SESSION = 100;
+constexpr uint32_t MAX_VECTOR_SIZE = 1000;
+
+// После аутентификации клиент вместо количества векторов может прислать
+// одно из зарезервированных значений и переключить сессию в другой режим.
+// Эти значения не пересекаются с допустимым диапазоном 1..MAX_VECTORS_PER_SESSION.
+constexpr uint32_t PROTOCOL_MODE_SHM = 0xFFFFFF01;     // Кольца в разделяемой памяти
+constexpr uint32_t PROTOCOL_MODE_TAGGED = 0xFFFFFF02;  // Запросы с номерами, ответы по готовности
+constexpr uint32_t PROTOCOL_MODE_FRAMED = 0xFFFFFF03;  // Протокол v2: пакеты с общим заголовком
+
+// Режим с номерами запросов.
+// Запрос: [uint32 номер][uint32 размер][float элементы]; размер 0 завершает сессию.
+// Ответ:  [uint32 номер][float произведение], порядок ответов не гарантируется.
+constexpr uint32_t MAX_TAGGED_VECTOR_SIZE = 1u << 20;
+constexpr uint32_t MAX_TAGGED_IN_FLIGHT = 256;
+
+// Протокол v2 (PROTOCOL_MODE_FRAMED). Сервер отвечает на выбор режима
+// [uint32 версия][uint32 поддерживаемые флаги], затем идут пакеты:
+// Запрос: [uint32 число векторов N][uint32 флаги][uint32 байт данных]
+//         [N x uint32 размер вектора][данные: все элементы подряд]
+// Ответ:  [uint32 N][N x float произведение]
+// Пакет с N = 0 завершает сессию. С флагом FRAMED_FLAG_LZ данные сжаты
+// (перестановка байтов + LZ, см. float_codec.h), иначе это элементы little-endian.
+// Биты 8-15 флагов - тип элементов (ElementType, по умолчанию float32); если
+// сервер в ответе на выбор режима не указал FRAMED_FLAG_TYPED, допустим только float32.
+// Произведения в ответе имеют тип resultWidth(): float64 и целые - свой тип,
+// bfloat16 - float32. Переполнение: -inf для вещественных, минимальное значение для целых.
+// Минимальное целое бывает и точным произведением, поэтому с флагом запроса
+// FRAMED_FLAG_STATUS ответ несет маску переполнений:
+//         [uint32 N][ceil(N / 32) x uint32 маска][N x произведение],
+// бит i % 32 слова i / 32 установлен, если произведение вектора i переполнилось.
+constexpr uint32_t FRAMED_PROTOCOL_VERSION = 2;
+constexpr uint32_t FRAMED_FLAG_LZ = 1u << 0;
+constexpr uint32_t FRAMED_FLAG_TYPED = 1u << 1;
+constexpr uint32_t FRAMED_FLAG_STATUS = 1u << 2;
+constexpr uint32_t FRAMED_TYPE_SHIFT = 8;
+constexpr uint32_t FRAMED_TYPE_MASK = 0xFFu << FRAMED_TYPE_SHIFT;
+constexpr uint32_t FRAMED_SUPPORTED_FLAGS = FRAMED_FLAG_LZ | FRAMED_FLAG_TYPED | FRAMED_FLAG_STATUS;
+constexpr uint32_t MAX_FRAMED_VECTORS = 1u << 16;
+constexpr uint32_t MAX_FRAMED_ELEMENTS = 1u << 22;  // 16 МБ данных на пакет
+
+enum class ElementType : uint8_t {
+    FLOAT32 = 0,
+    FLOAT64 = 1,
+    INT32 = 2,
+    INT64 = 3,
+    BFLOAT16 = 4,  // Старшие 16 бит float32
+    TYPE_COUNT
+};
+
+constexpr size_t elementWidth(ElementType type) {
+    return type == ElementType::FLOAT64 || type == ElementType::INT64 ? 8
+         : type == ElementType::BFLOAT16 ? 2 : 4;
+}
+
+constexpr size_t resultWidth(ElementType type) {
+    return type == ElementType::FLOAT64 || type == ElementType::INT64 ? 8 : 4;
+}
+
+// Байт маски переполнений в ответе с FRAMED_FLAG_STATUS
+constexpr size_t overflowMaskBytes(uint32_t count) {
+    return (count + 31) / 32 * sizeof(uint32_t);
+}
+
+// Короткое имя типа для логов и параметров командной строки
+constexpr const char* elementTypeName(ElementType type) {
+    return type == ElementType::FLOAT32 ? "f32"
+         : type == ElementType::FLOAT64 ? "f64"
+         : type == ElementType::INT32 ? "i32"
+         : type == ElementType::INT64 ? "i64"
+         : type == ElementType::BFLOAT16 ? "bf16" : "unknown";
+}
+
+// UDP-режим: запрос и ответ помещаются в одну датаграмму.
+// Запрос:  [uint8 длина логина][логин][uint64 метка времени][40 байт токена]
+//          [uint32 номер запроса][uint32 размер вектора][float элементы]
+// Ответ:   [uint32 номер запроса][uint32 статус][float произведение]
+// Токен - HMAC-SHA1 с паролем в качестве ключа над [uint64 метка времени] и всем,
+// что идет в датаграмме после токена, в hex; все числа little-endian.
+// Датаграмма с уже принятыми логином, меткой времени и номером запроса отклоняется,
+// поэтому клиент не повторяет номера в пределах UDP_MAX_CLOCK_SKEW.
+constexpr size_t UDP_TOKEN_LENGTH = 40;
+constexpr uint64_t UDP_MAX_CLOCK_SKEW = 30;
+constexpr size_t UDP_MAX_DATAGRAM = 1 + 255 + 8 + UDP_TOKEN_LENGTH + 4 + 4 + MAX_VECTOR_SIZE * 4;
+constexpr size_t UDP_RESPONSE_SIZE = 12;
+
+enum UdpStatus : uint32_t {
+    UDP_STATUS_OK = 0,
+    UDP_STATUS_AUTH_FAILED = 1,
+    UDP_STATUS_BAD_REQUEST = 2,
+    UDP_STATUS_RATE_LIMITED = 3
+};
+
+#endif // PROTOCOL_H
@@ -0,0 +1,327 @@
+#include "proxy.h"
+#include "client.h"
+#include "error_handler.h"
+#include "affinity.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Размер буфера канала: столько байт может ждать отправки в каждую сторону
+static const size_t PROXY_PIPE_CAPACITY = 1 << 16;
+// Соединение без трафика дольше этого времени закрывается
+static const int PROXY_IDLE_TIMEOUT_MS = 10 * 60 * 1000;
+static const int PROXY_CONNECT_TIMEOUT_MS = 2000;
+
+Proxy::Proxy(Logger& logger, Policy policy, int healthIntervalSeconds)
+    : logger_(logger), policy_(policy), healthIntervalSeconds_(healthIntervalSeconds),
+      random_(std::random_device{}()), nextBackend_(0), stopping_(false) {
+}
+
+Proxy::~Proxy() {
+    stop();
+}
+
+bool Proxy::parsePolicy(const std::string& name, Policy& policy) {
+    if (name == "least-conn") {
+        policy = Policy::LEAST_CONNECTIONS;
+    } else if (name == "p2c") {
+        policy = Policy::POWER_OF_TWO;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void Proxy::addBackend(const std::string& spec) {
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        throw ConfigException("Backend must be HOST:PORT: " + spec);
+    }
+
+    std::unique_ptr<Backend> backend(new Backend());
+    backend->host = spec.substr(0, colon);
+    try {
+        size_t used = 0;
+        long port = std::stol(spec.substr(colon + 1), &used);
+        if (used != spec.size() - colon - 1 || port < 1 || port > 65535) {
+            throw ConfigException("Invalid backend port: " + spec);
+        }
+        backend->port = static_cast<uint16_t>(port);
+    } catch (const std::invalid_argument&) {
+        throw ConfigException("Invalid backend port: " + spec);
+    } catch (const std::out_of_range&) {
+        throw ConfigException("Invalid backend port: " + spec);
+    }
+
+    // Адрес разрешается один раз при запуске, а не на каждое подключение
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(backend->host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+        throw ConfigException("Cannot resolve backend host: " + backend->host);
+    }
+    memcpy(&backend->address, result->ai_addr, sizeof(backend->address));
+    backend->address.sin_port = htons(backend->port);
+    freeaddrinfo(result);
+
+    backends_.push_back(std::move(backend));
+}
+
+void Proxy::start(const std::string& healthUser, const std::string& healthPassword) {
+    healthUser_ = healthUser;
+    healthPassword_ = healthPassword;
+    checkAll();
+    healthThread_ = std::thread(&Proxy::healthLoop, this);
+}
+
+void Proxy::stop() {
+    {
+        std::lock_guard<std::mutex> lock(healthMutex_);
+        stopping_ = true;
+    }
+    healthWake_.notify_all();
+    if (healthThread_.joinable()) {
+        healthThread_.join();
+    }
+}
+
+void Proxy::healthLoop() {
+    nameCurrentThread("vcalc-health");
+    std::unique_lock<std::mutex> lock(healthMutex_);
+    while (!stopping_) {
+        healthWake_.wait_for(lock, std::chrono::seconds(healthIntervalSeconds_));
+        if (stopping_) {
+            break;
+        }
+        lock.unlock();
+        checkAll();
+        lock.lock();
+    }
+}
+
+void Proxy::checkAll() {
+    for (auto& backend : backends_) {
+        bool healthy = checkBackend(*backend);
+        bool wasHealthy = backend->healthy.exchange(healthy);
+        if (!healthy) {
+            backend->failedChecks++;
+        }
+        if (healthy != wasHealthy) {
+            std::string name = backend->host + ":" + std::to_string(backend->port);
+            if (healthy) {
+                logger_.info("Backend " + name + " is healthy");
+            } else {
+                logger_.warning("Backend " + name + " failed health check");
+            }
+        }
+    }
+}
+
+bool Proxy::checkBackend(Backend& backend) {
+    // Проверка проходит весь путь клиента: вход по SHA-1 и вычисление
+    VcalcClient client;
+    client.setTimeout(PROXY_CONNECT_TIMEOUT_MS);
+    std::vector<std::vector<float>> vectors(1, std::vector<float>(1, 1.0f));
+    std::vector<float> results;
+    return client.connectTcp(backend.host, backend.port) &&
+           client.login(healthUser_, healthPassword_) &&
+           client.computeProducts(vectors, results) &&
+           results.size() == 1 && results[0] == 1.0f;
+}
+
+Proxy::Backend* Proxy::chooseBackend(const Backend* exclude) {
+    std::vector<Backend*> candidates;
+    for (auto& backend : backends_) {
+        if (backend->healthy && backend.get() != exclude) {
+            candidates.push_back(backend.get());
+        }
+    }
+    if (candidates.empty()) {
+        return nullptr;
+    }
+
+    if (policy_ == Policy::POWER_OF_TWO && candidates.size() > 2) {
+        // Два случайных кандидата, берем менее загруженного
+        size_t first;
+        size_t second;
+        {
+            std::lock_guard<std::mutex> lock(randomMutex_);
+            std::uniform_int_distribution<size_t> pick(0, candidates.size() - 1);
+            first = pick(random_);
+            do {
+                second = pick(random_);
+            } while (second == first);
+        }
+        Backend* a = candidates[first];
+        Backend* b = candidates[second];
+        return b->active < a->active ? b : a;
+    }
+
+    // Наименьшее число соединений; при равенстве - по кругу, чтобы
+    // одновременные подключения не попадали все на первый сервер
+    size_t start = nextBackend_++ % candidates.size();
+    Backend* best = nullptr;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        Backend* backend = candidates[(start + i) % candidates.size()];
+        if (!best || backend->active < best->active) {
+            best = backend;
+        }
+    }
+    return best;
+}
+
+int Proxy::connectBackend(Backend& backend) {
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        return -1;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = PROXY_CONNECT_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (PROXY_CONNECT_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (connect(sock, reinterpret_cast<struct sockaddr*>(&backend.address), sizeof(backend.address)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool Proxy::pump(int from, int to, int pipeRead, int pipeWrite, size_t& buffered, bool& eof) {
+    if (!eof && buffered < PROXY_PIPE_CAPACITY) {
+        ssize_t n = splice(from, nullptr, pipeWrite, nullptr, PROXY_PIPE_CAPACITY - buffered,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            buffered += static_cast<size_t>(n);
+        } else if (n == 0) {
+            eof = true;
+        } else if (errno != EAGAIN && errno != EINTR) {
+            return false;
+        }
+    }
+
+    if (buffered > 0) {
+        ssize_t n = splice(pipeRead, nullptr, to, nullptr, buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            buffered -= static_cast<size_t>(n);
+        } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Proxy::relay(int clientSocket, const std::string& clientIP) {
+    Backend* backend = chooseBackend(nullptr);
+    int backendSocket = -1;
+
+    // Если сервер перестал отвечать между проверками, пробуем другой
+    for (size_t attempt = 0; backend && attempt < backends_.size(); ++attempt) {
+        backendSocket = connectBackend(*backend);
+        if (backendSocket != -1) {
+            break;
+        }
+        logger_.warning("Cannot connect to backend " + backend->host + ":" +
+                        std::to_string(backend->port) + ": " + std::string(strerror(errno)));
+        backend->healthy = false;
+        backend = chooseBackend(backend);
+    }
+
+    if (backendSocket == -1) {
+        logger_.error("No healthy backend for client " + clientIP);
+        return;
+    }
+
+    backend->active++;
+    backend->total++;
+    logger_.info("Client " + clientIP + " proxied to " + backend->host + ":" + std::to_string(backend->port));
+
+    int upstream[2] = {-1, -1};
+    int downstream[2] = {-1, -1};
+    if (pipe2(upstream, O_CLOEXEC | O_NONBLOCK) != 0 || pipe2(downstream, O_CLOEXEC | O_NONBLOCK) != 0) {
+        logger_.error("Failed to create relay pipes: " + std::string(strerror(errno)));
+    } else {
+        fcntl(upstream[1], F_SETPIPE_SZ, static_cast<int>(PROXY_PIPE_CAPACITY));
+        fcntl(downstream[1], F_SETPIPE_SZ, static_cast<int>(PROXY_PIPE_CAPACITY));
+        fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK);
+        fcntl(backendSocket, F_SETFL, fcntl(backendSocket, F_GETFL, 0) | O_NONBLOCK);
+
+        size_t upBuffered = 0;
+        size_t downBuffered = 0;
+        bool clientEof = false;
+        bool backendEof = false;
+        bool backendShut = false;
+        bool clientShut = false;
+
+        while (true) {
+            if (!pump(clientSocket, backendSocket, upstream[0], upstream[1], upBuffered, clientEof) ||
+                !pump(backendSocket, clientSocket, downstream[0], downstream[1], downBuffered, backendEof)) {
+                break;
+            }
+
+            // Полузакрытие передается дальше, когда все данные доставлены
+            if (clientEof && upBuffered == 0 && !backendShut) {
+                shutdown(backendSocket, SHUT_WR);
+                backendShut = true;
+            }
+            if (backendEof && downBuffered == 0 && !clientShut) {
+                shutdown(clientSocket, SHUT_WR);
+                clientShut = true;
+            }
+            if (backendShut && clientShut) {
+                break;
+            }
+
+            struct pollfd fds[2];
+            fds[0] = {clientSocket, 0, 0};
+            fds[1] = {backendSocket, 0, 0};
+            if (!clientEof && upBuffered < PROXY_PIPE_CAPACITY) fds[0].events |= POLLIN;
+            if (downBuffered > 0) fds[0].events |= POLLOUT;
+            if (!backendEof && downBuffered < PROXY_PIPE_CAPACITY) fds[1].events |= POLLIN;
+            if (upBuffered > 0) fds[1].events |= POLLOUT;
+
+            int ready = poll(fds, 2, PROXY_IDLE_TIMEOUT_MS);
+            if (ready == 0) {
+                logger_.warning("Proxied connection from " + clientIP + " idle, closing");
+                break;
+            }
+            if (ready < 0 && errno != EINTR) {
+                break;
+            }
+            if ((fds[0].revents | fds[1].revents) & (POLLERR | POLLNVAL)) {
+                break;
+            }
+        }
+    }
+
+    for (int fd : {upstream[0], upstream[1], downstream[0], downstream[1]}) {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+    close(backendSocket);
+    backend->active--;
+}
+
+std::string Proxy::describe() const {
+    std::ostringstream out;
+    out << "backends: " << backends_.size() << " policy: "
+        << (policy_ == Policy::POWER_OF_TWO ? "p2c" : "least-conn") << "\n";
+    for (const auto& backend : backends_) {
+        out << "  backend " << backend->host << ":" << backend->port
+            << " healthy=" << (backend->healthy ? "yes" : "no")
+            << " active=" << backend->active
+            << " total=" << backend->total
+            << " failed_checks=" << backend->failedChecks << "\n";
+    }
+    return out.str();
+}
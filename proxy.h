@@ -0,0 +1,82 @@
+#ifndef PROXY_H
+#define PROXY_H
+
+#include "logger.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+// Балансировщик уровня L4: клиентское соединение связывается с одним из
+// серверов-бэкендов, байты переливаются через splice() без копирования в
+// пространство пользователя. Протокол не разбирается, кроме проверки
+// здоровья: она выполняет настоящий вход и вычисление короткого вектора.
+class Proxy {
+public:
+    enum class Policy {
+        LEAST_CONNECTIONS,
+        POWER_OF_TWO
+    };
+
+    struct Backend {
+        std::string host;
+        uint16_t port;
+        struct sockaddr_in address;
+        std::atomic<bool> healthy{false};
+        std::atomic<int> active{0};
+        std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> failedChecks{0};
+    };
+
+private:
+    Logger& logger_;
+    std::vector<std::unique_ptr<Backend>> backends_;
+    Policy policy_;
+    std::string healthUser_;
+    std::string healthPassword_;
+    int healthIntervalSeconds_;
+
+    std::mutex randomMutex_;
+    std::mt19937 random_;
+    std::atomic<size_t> nextBackend_;
+
+    std::thread healthThread_;
+    std::mutex healthMutex_;
+    std::condition_variable healthWake_;
+    bool stopping_;
+
+public:
+    Proxy(Logger& logger, Policy policy, int healthIntervalSeconds);
+    ~Proxy();
+
+    Proxy(const Proxy&) = delete;
+    Proxy& operator=(const Proxy&) = delete;
+
+    // "host:port"; при ошибке бросает ConfigException
+    void addBackend(const std::string& spec);
+
+    // Первая проверка выполняется синхронно, затем - в фоновом потоке
+    void start(const std::string& healthUser, const std::string& healthPassword);
+    void stop();
+
+    // Обслуживает клиента до закрытия соединения; clientSocket закрывает вызывающий
+    void relay(int clientSocket, const std::string& clientIP);
+
+    std::string describe() const;
+    static bool parsePolicy(const std::string& name, Policy& policy);
+
+private:
+    Backend* chooseBackend(const Backend* exclude);
+    int connectBackend(Backend& backend);
+    bool checkBackend(Backend& backend);
+    void checkAll();
+    void healthLoop();
+    bool pump(int from, int to, int pipeRead, int pipeWrite, size_t& buffered, bool& eof);
+};
+
+#endif // PROXY_H
@@ -0,0 +1,441 @@
+// vcalc-replay: воспроизведение трафика, записанного сервером с --capture.
+// Каждая записанная сессия идет по своему соединению с прежними паузами
+// (или быстрее, см. --speed): клиентские байты отправляются как были,
+// ответы сервера дочитываются до записанной длины. Хеш пароля считается
+// заново по соли сервера. Итог сравнивается с отчетом прошлого прогона
+// (--baseline), например той же записи на предыдущей сборке.
+#include "capture.h"
+#include "client.h"
+#include "protocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <endian.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReplayOptions {
+    std::string captureFile;
+    std::string tcpAddress;
+    std::string unixPath;
+    std::string baselineFile;
+    std::string user;  // Пустой - логины из записи
+    std::string password = "P@ssW0rd";
+    double speed = 1.0;
+    int timeoutMs = 10000;
+};
+
+struct ReplayStep {
+    CaptureRecord kind;
+    uint64_t offsetNs;  // От начала сессии
+    uint32_t length;
+    std::string data;
+};
+
+struct RecordedSession {
+    uint64_t id = 0;
+    uint64_t startNs = 0;
+    bool opened = false;
+    std::vector<ReplayStep> steps;
+};
+
+// Итоги прогона; задержка - от отправки запроса до получения первого ответа на него
+struct ReplayTotals {
+    std::mutex mutex;
+    size_t replayed = 0;
+    size_t skipped = 0;
+    size_t failed = 0;
+    uint64_t bytesSent = 0;
+    std::vector<double> latencies;
+    std::string firstError;
+};
+
+static void showUsage() {
+    std::cout << "Usage: vcalc-replay --capture FILE (--tcp HOST:PORT | --unix PATH) [OPTIONS]\n\n"
+              << "Replays client sessions recorded by 'server --capture FILE'.\n\n"
+              << "Options:\n"
+              << "  --speed X           Time scale: 1 keeps the recorded pacing (default),\n"
+              << "                      10 replays ten times faster, 0 without pauses\n"
+              << "  --user NAME         Log in as NAME instead of the recorded logins\n"
+              << "  --password PASS     Password for the replayed logins (default: P@ssW0rd)\n"
+              << "  --timeout MS        Per-operation timeout (default: 10000)\n"
+              << "  --baseline FILE     Compare with a saved report of an earlier replay\n\n"
+              << "Shared memory sessions cannot be replayed and are skipped. Recorded\n"
+              << "latencies are measured by the server, replayed ones by this tool.\n";
+}
+
+static bool parseOptions(int argc, char* argv[], ReplayOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--capture") options.captureFile = value;
+        else if (arg == "--tcp") options.tcpAddress = value;
+        else if (arg == "--unix") options.unixPath = value;
+        else if (arg == "--baseline") options.baselineFile = value;
+        else if (arg == "--user") options.user = value;
+        else if (arg == "--password") options.password = value;
+        else if (arg == "--speed") options.speed = std::stod(value);
+        else if (arg == "--timeout") options.timeoutMs = std::stoi(value);
+        else throw std::invalid_argument("Unknown option: " + arg);
+    }
+
+    if (options.captureFile.empty()) {
+        throw std::invalid_argument("--capture is required");
+    }
+    if (options.tcpAddress.empty() == options.unixPath.empty()) {
+        throw std::invalid_argument("Exactly one of --tcp or --unix is required");
+    }
+    if (options.speed < 0) {
+        throw std::invalid_argument("--speed must not be negative");
+    }
+    return true;
+}
+
+static bool loadCapture(const std::string& path, std::vector<RecordedSession>& sessions) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "vcalc-replay: cannot open " << path << std::endl;
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(CAPTURE_MAGIC) || memcmp(data.data(), CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+        std::cerr << "vcalc-replay: " << path << ": not a vcalc capture" << std::endl;
+        return false;
+    }
+
+    std::map<uint64_t, RecordedSession> byId;
+    size_t offset = sizeof(CAPTURE_MAGIC);
+    while (offset < data.size()) {
+        CaptureEntry entry;
+        size_t length = decodeCaptureRecord(data.data() + offset, data.size() - offset, entry);
+        if (length == 0) {
+            // Хвост без полной записи бывает, если сервер был убит во время записи
+            std::cerr << "vcalc-replay: " << path << ": damaged or truncated record at offset "
+                      << offset << ", ignoring the rest" << std::endl;
+            break;
+        }
+        offset += length;
+
+        RecordedSession& session = byId[entry.session];
+        if (entry.kind == CaptureRecord::OPEN) {
+            session.id = entry.session;
+            session.startNs = entry.timeNs;
+            session.opened = true;
+            continue;
+        }
+        // Сессия, начатая до начала записи, не воспроизводится
+        if (!session.opened) {
+            continue;
+        }
+
+        ReplayStep step;
+        step.kind = entry.kind;
+        step.offsetNs = entry.timeNs - session.startNs;
+        step.length = entry.length;
+        if (entry.data != nullptr) {
+            step.data.assign(entry.data, entry.length);
+        }
+        session.steps.push_back(step);
+    }
+
+    for (auto& item : byId) {
+        if (item.second.opened) {
+            sessions.push_back(std::move(item.second));
+        }
+    }
+    std::sort(sessions.begin(), sessions.end(), [](const RecordedSession& a, const RecordedSession& b) {
+        return a.startNs < b.startNs;
+    });
+    return true;
+}
+
+// Режим колец в разделяемой памяти: дальше данные идут мимо сокета
+static bool usesSharedMemory(const RecordedSession& session) {
+    for (const ReplayStep& step : session.steps) {
+        if (step.kind == CaptureRecord::DATA) {
+            uint32_t mode = 0;
+            if (step.data.size() >= sizeof(mode)) {
+                memcpy(&mode, step.data.data(), sizeof(mode));
+            }
+            return le32toh(mode) == PROTOCOL_MODE_SHM;
+        }
+    }
+    return false;
+}
+
+// Задержки, как их видел сервер: от прихода запроса до отправки первого ответа
+static void recordedLatencies(const std::vector<RecordedSession>& sessions, std::vector<double>& latencies) {
+    for (const RecordedSession& session : sessions) {
+        bool awaiting = false;
+        uint64_t requestNs = 0;
+        for (const ReplayStep& step : session.steps) {
+            if (step.kind == CaptureRecord::DATA && !awaiting) {
+                awaiting = true;
+                requestNs = step.offsetNs;
+            } else if (step.kind == CaptureRecord::REPLY && awaiting) {
+                awaiting = false;
+                latencies.push_back((step.offsetNs - requestNs) / 1000.0);
+            }
+        }
+    }
+}
+
+static void splitAddress(const std::string& address, std::string& host, uint16_t& port) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::invalid_argument("Address must be HOST:PORT: " + address);
+    }
+    host = address.substr(0, colon);
+    port = static_cast<uint16_t>(std::stoul(address.substr(colon + 1)));
+}
+
+static bool replaySession(const RecordedSession& session, const ReplayOptions& options,
+                          std::vector<double>& latencies, uint64_t& bytesSent, std::string& error) {
+    VcalcClient client;
+    client.setTimeout(options.timeoutMs);
+    bool connected;
+    if (!options.unixPath.empty()) {
+        connected = client.connectUnix(options.unixPath);
+    } else {
+        std::string host;
+        uint16_t port;
+        splitAddress(options.tcpAddress, host, port);
+        connected = client.connectTcp(host, port);
+    }
+    if (!connected) {
+        error = client.lastError();
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto requestStart = start;
+    bool awaiting = false;
+    bool requested = false;
+    std::vector<char> reply;
+
+    for (const ReplayStep& step : session.steps) {
+        switch (step.kind) {
+            case CaptureRecord::LOGIN:
+                // Соль, хеш и результат проверки заменяет одно рукопожатие клиента
+                if (!client.login(options.user.empty() ? step.data : options.user, options.password)) {
+                    error = client.lastError();
+                    return false;
+                }
+                break;
+            case CaptureRecord::DATA:
+                if (options.speed > 0) {
+                    std::this_thread::sleep_until(start + std::chrono::nanoseconds(
+                        static_cast<uint64_t>(step.offsetNs / options.speed)));
+                }
+                if (!awaiting) {
+                    awaiting = true;
+                    requested = true;
+                    requestStart = std::chrono::steady_clock::now();
+                }
+                if (!client.sendAll(step.data.data(), step.data.size())) {
+                    error = client.lastError();
+                    return false;
+                }
+                bytesSent += step.data.size();
+                break;
+            case CaptureRecord::REPLY:
+                // Ответы до первого запроса относятся к аутентификации
+                if (!requested) {
+                    break;
+                }
+                reply.resize(step.length);
+                if (!client.receiveAll(reply.data(), reply.size())) {
+                    error = client.lastError();
+                    return false;
+                }
+                if (awaiting) {
+                    awaiting = false;
+                    latencies.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - requestStart).count());
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+struct LatencySummary {
+    size_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+};
+
+static LatencySummary summarize(std::vector<double>& latencies) {
+    LatencySummary summary;
+    summary.count = latencies.size();
+    if (latencies.empty()) {
+        return summary;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    for (double latency : latencies) {
+        summary.mean += latency;
+    }
+    summary.mean /= latencies.size();
+    summary.p50 = latencies[latencies.size() / 2];
+    summary.p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    return summary;
+}
+
+// Значения key=value из строки отчета, начинающейся с prefix
+static std::map<std::string, double> readReportLine(const std::string& path, const std::string& prefix) {
+    std::map<std::string, double> values;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::istringstream fields(line.substr(prefix.size()));
+        std::string field;
+        while (fields >> field) {
+            size_t equals = field.find('=');
+            if (equals != std::string::npos) {
+                values[field.substr(0, equals)] = std::atof(field.c_str() + equals + 1);
+            }
+        }
+        break;
+    }
+    return values;
+}
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            showUsage();
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "vcalc-replay: " << e.what() << std::endl;
+        showUsage();
+        return 1;
+    }
+
+    std::vector<RecordedSession> sessions;
+    if (!loadCapture(options.captureFile, sessions)) {
+        return 1;
+    }
+    if (sessions.empty()) {
+        std::cerr << "vcalc-replay: no sessions in " << options.captureFile << std::endl;
+        return 1;
+    }
+
+    ReplayTotals totals;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t firstStartNs = sessions.front().startNs;
+
+    // Сессии начинаются с прежними интервалами, каждая в своем потоке
+    for (const RecordedSession& session : sessions) {
+        if (usesSharedMemory(session)) {
+            totals.skipped++;
+            continue;
+        }
+        if (options.speed > 0) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(
+                static_cast<uint64_t>((session.startNs - firstStartNs) / options.speed)));
+        }
+        threads.emplace_back([&session, &options, &totals] {
+            std::vector<double> latencies;
+            uint64_t bytesSent = 0;
+            std::string error;
+            bool ok = replaySession(session, options, latencies, bytesSent, error);
+
+            std::lock_guard<std::mutex> lock(totals.mutex);
+            totals.replayed++;
+            totals.bytesSent += bytesSent;
+            totals.latencies.insert(totals.latencies.end(), latencies.begin(), latencies.end());
+            if (!ok) {
+                totals.failed++;
+                if (totals.firstError.empty()) {
+                    totals.firstError = error;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (totals.failed > 0) {
+        std::cerr << "vcalc-replay: " << totals.failed << " sessions failed, first error: "
+                  << totals.firstError << std::endl;
+    }
+
+    std::vector<double> recorded;
+    recordedLatencies(sessions, recorded);
+    LatencySummary replayedSummary = summarize(totals.latencies);
+    LatencySummary recordedSummary = summarize(recorded);
+
+    std::map<std::string, double> current;
+    current["requests/s"] = replayedSummary.count / seconds;
+    current["MB/s"] = totals.bytesSent / seconds / (1024.0 * 1024.0);
+    current["latency_mean_us"] = replayedSummary.mean;
+    current["latency_p50_us"] = replayedSummary.p50;
+    current["latency_p99_us"] = replayedSummary.p99;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "sessions=" << sessions.size()
+              << " replayed=" << totals.replayed
+              << " skipped=" << totals.skipped
+              << " failed=" << totals.failed
+              << " speed=" << options.speed << "\n"
+              << "replay   requests=" << replayedSummary.count
+              << " time=" << seconds << "s";
+    for (const char* key : {"requests/s", "MB/s", "latency_mean_us", "latency_p50_us", "latency_p99_us"}) {
+        std::cout << " " << key << "=" << current[key];
+    }
+    std::cout << "\n"
+              << "recorded requests=" << recordedSummary.count
+              << " latency_mean_us=" << recordedSummary.mean
+              << " latency_p50_us=" << recordedSummary.p50
+              << " latency_p99_us=" << recordedSummary.p99 << "\n";
+
+    if (!options.baselineFile.empty()) {
+        std::map<std::string, double> baseline = readReportLine(options.baselineFile, "replay ");
+        if (baseline.empty()) {
+            std::cerr << "vcalc-replay: no replay results in " << options.baselineFile << std::endl;
+            return 1;
+        }
+        // Для пропускной способности рост - улучшение, для задержек - ухудшение
+        std::cout << "change  ";
+        for (const char* key : {"requests/s", "MB/s", "latency_mean_us", "latency_p50_us", "latency_p99_us"}) {
+            double before = baseline[key];
+            std::cout << " " << key << "=";
+            if (before > 0) {
+                std::cout << std::showpos << (current[key] / before - 1.0) * 100.0 << std::noshowpos << "%";
+            } else {
+                std::cout << "n/a";
+            }
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::flush;
+    return totals.failed > 0 ? 1 : 0;
+}
@@ -1,26 +1,85 @@
 #include "server.h"
+#include "vector_math.h"
+#include "float_codec.h"
 #include <iostream>
 #include <csignal>
 #include <sstream>
 #include <cmath>
 #include <limits>
 #include <thread>
+#include <cstdlib>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <mutex>
+#include <algorithm>
+#include <functional>
+
+// Переменная окружения, через которую новый процесс узнает путь канала передачи сокетов
+static const char* HANDOFF_ENV = "VCALC_HANDOFF_SOCKET";
+
+// Емкость каждого из колец сессии в разделяемой памяти
+static const uint64_t SHM_RING_CAPACITY = 1 << 20;
+
+// Как часто писать в лог статистику по клиентам
+static const auto CLIENT_STATS_INTERVAL = std::chrono::seconds(60);
+
+static ClientLimits makeClientLimits(const ServerConfig& config) {
+    ClientLimits limits;
+    limits.vectorsPerSecond = config.rateVectors;
+    limits.elementsPerSecond = config.rateElements;
+    return limits;
+}
+
+// Общее состояние сессии с номерами запросов: читающий поток и задачи пула
+struct TaggedSession {
+    std::mutex sendMutex;
+    std::mutex stateMutex;
+    std::condition_variable changed;
+    size_t inFlight = 0;
+    bool failed = false;
+};
 
 // Глобальная переменная для обработки сигналов
 std::atomic<bool> g_running{true};
+std::atomic<bool> g_upgradeRequested{false};
 
 void signalHandler(int signal) {
     g_running = false;
     std::cout << "Received signal " << signal << ", shutting down..." << std::endl;
 }
 
+void upgradeSignalHandler(int) {
+    g_upgradeRequested = true;
+}
+
 Server::Server(const ServerConfig& config)
     : config_(config),
-      logger_(config.logFile),
+      logger_(config.logFile, config.binaryLog ? LogOutput::BINARY : LogOutput::TEXT),
       authenticator_(logger_),
       network_(logger_),
-      running_(false) {
+      scheduler_(makeClientLimits(config), config.clientWeights),
+      memory_(config.memoryLimit, config.connectionMemoryLimit, std::chrono::milliseconds(config.memoryWaitMs)),
+      udp_(logger_, authenticator_, scheduler_, config.fairnessByLogin),
+      ioTotals_(),
+      ioSessions_(0),
+      ioVectors_(0),
+      running_(false),
+      activeSessions_(0),
+      nextSessionId_(1),
+      draining_(false),
+      ready_(false),
+      preforkWorker_(false),
+      admin_(logger_, [this](const std::string& command) { return handleAdminCommand(command); }) {
     updateActivity(); // Инициализируем время последней активности
+    lastStatsReport_ = std::chrono::steady_clock::now();
+    logger_.setSampling(config.logSampleEvery, config.logRateLimit);
+    logger_.setRotation(config.logMaxSize, config.logMaxAge, config.logKeepFiles, config.logCompress);
+    network_.setTcpTuning(config.tcp);
+    if (config.ioStats) {
+        IoStats::enable();
+    }
 }
 
 Server::~Server() {
@@ -31,36 +90,363 @@ bool Server::initialize() {
     logger_.info("Initializing server...");
     logger_.info("Server settings: port=" + std::to_string(config_.port) + ", user=P@ssW0rd");
     
-    // Загрузка базы пользователей
-    if (!authenticator_.loadUsers(config_.clientDbFile)) {
+    // Загрузка базы пользователей (при --lazy-init - в completeInitialization)
+    if (!config_.lazyInit && !authenticator_.loadUsers(config_.clientDbFile)) {
         logger_.error("Failed to load user database");
         return false;
     }
     
+    // При горячем перезапуске слушающие сокеты передает предыдущий процесс
+    const char* handoffPath = std::getenv(HANDOFF_ENV);
+    if (handoffPath != nullptr) {
+        std::string path = handoffPath;
+        unsetenv(HANDOFF_ENV);
+        
+        if (!network_.adoptListeners(path, config_.unixSocket)) {
+            logger_.error("Failed to adopt listening sockets from " + path);
+            return false;
+        }
+    }
+    // Запуск по требованию: сокеты уже слушает менеджер служб
+    else if (NetworkManager::socketActivationRequested()) {
+        if (!network_.adoptActivatedSockets()) {
+            logger_.error("Failed to adopt sockets passed by the service manager");
+            return false;
+        }
+    }
     // Инициализация сетевого модуля на указанном порту
-    if (!network_.initialize(config_.port)) {
+    else if (config_.tcpEnabled && !network_.initialize(config_.port)) {
         logger_.error("Failed to initialize network on port " + std::to_string(config_.port));
         return false;
     }
     
+    // Unix-сокет для клиентов на том же хосте
+    if (!config_.unixSocket.empty() && network_.getUnixSocket() == -1 &&
+        !network_.initializeUnix(config_.unixSocket)) {
+        logger_.error("Failed to initialize Unix socket " + config_.unixSocket);
+        return false;
+    }
+    
+    // UDP-режим для коротких запросов из одной датаграммы
+    if (config_.udpPort != 0 && network_.getUdpSocket() == -1 &&
+        !network_.initializeUdp(config_.udpPort)) {
+        logger_.error("Failed to initialize UDP on port " + std::to_string(config_.udpPort));
+        return false;
+    }
+    
+    network_.confirmHandoff();
+    
+    if (!config_.proxyBackends.empty() && !startProxy()) {
+        return false;
+    }
+    
+    // Файл открывается до fork(): рабочие процессы пишут в него же
+    if (!config_.captureFile.empty() && !startCapture()) {
+        return false;
+    }
+    
+    if (!config_.profileFile.empty()) {
+        if (!profiler_.start(config_.profileHz)) {
+            logger_.error("Failed to start profiler");
+            return false;
+        }
+        logger_.info("Profiling at " + std::to_string(config_.profileHz) + " Hz, stacks are written to " +
+                     config_.profileFile);
+    }
+    
+    if (config_.processes > 1) {
+        // Рабочие процессы создадут свои пулы потоков после fork()
+        if (!authenticator_.shareUsers()) {
+            return false;
+        }
+        // Подключение забирает первый успевший процесс, остальные не должны блокироваться в accept
+        network_.setListenersNonBlocking();
+    } else if (!config_.lazyInit) {
+        startWorkerPool();
+    }
+    ready_ = !config_.lazyInit;
+    
+    // Административный сокет запускается последним: команды обращаются к пулу
+    if (!config_.adminSocket.empty() && !admin_.start(config_.adminSocket)) {
+        logger_.error("Failed to initialize admin socket " + config_.adminSocket);
+        return false;
+    }
+    
     logger_.info("Server initialized successfully on port " + std::to_string(config_.port));
     logger_.info("Waiting for client connections...");
     return true;
 }
 
+bool Server::completeInitialization() {
+    auto started = std::chrono::steady_clock::now();
+    
+    if (!authenticator_.loadUsers(config_.clientDbFile)) {
+        logger_.error("Failed to load user database");
+        return false;
+    }
+    startWorkerPool();
+    ready_ = true;
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started);
+    logger_.info("Deferred initialization completed in " + std::to_string(elapsed.count()) + " us");
+    return true;
+}
+
+bool Server::initializeLocal() {
+    logger_.info("Initializing in-process server...");
+    
+    if (!authenticator_.loadUsers(config_.clientDbFile)) {
+        logger_.error("Failed to load user database");
+        return false;
+    }
+    
+    if (!config_.captureFile.empty() && !startCapture()) {
+        return false;
+    }
+    
+    startWorkerPool();
+    ready_ = true;
+    running_ = true;
+    return true;
+}
+
+void Server::serveLocal(Transport& transport, int connection, const std::string& peer) {
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        activeSessions_++;
+    }
+    runSession(transport, connection, peer);
+}
+
+bool Server::startCapture() {
+    capture_.reset(new TrafficCapture());
+    if (!capture_->open(config_.captureFile)) {
+        logger_.error("Failed to open capture file " + config_.captureFile + ": " + strerror(errno));
+        capture_.reset();
+        return false;
+    }
+    logger_.info("Recording client traffic to " + config_.captureFile);
+    return true;
+}
+
+bool Server::startProxy() {
+    Proxy::Policy policy = Proxy::Policy::LEAST_CONNECTIONS;
+    Proxy::parsePolicy(config_.proxyPolicy, policy);
+    proxy_.reset(new Proxy(logger_, policy, config_.healthInterval));
+    for (const auto& backend : config_.proxyBackends) {
+        proxy_->addBackend(backend);
+    }
+    
+    // Проверка здоровья входит под учетной записью из собственной базы клиентов
+    std::string password;
+    if (!authenticator_.findPassword(config_.healthUser, password)) {
+        logger_.error("Health check user not found in client database: " + config_.healthUser);
+        return false;
+    }
+    proxy_->start(config_.healthUser, password);
+    logger_.info("Proxy mode: " + std::to_string(config_.proxyBackends.size()) +
+                 " backends, policy " + config_.proxyPolicy);
+    return true;
+}
+
+void Server::startWorkerPool() {
+    size_t workerThreads = config_.workerThreads;
+    if (workerThreads == 0) {
+        workerThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Каждый вычислительный поток получает свой процессор из списка
+    auto initWorker = [this](size_t index) {
+        nameCurrentThread("vcalc-worker");
+        if (config_.computeCpus.empty()) {
+            return;
+        }
+        CpuList cpu(1, config_.computeCpus[index % config_.computeCpus.size()]);
+        if (!pinCurrentThread(cpu)) {
+            logger_.warning("Failed to pin compute worker to CPU " + formatCpuList(cpu));
+        }
+    };
+    workers_.reset(new WorkerPool(workerThreads, initWorker));
+    logger_.info("Compute worker threads: " + std::to_string(workerThreads) +
+                 ", CPUs: " + formatCpuList(config_.computeCpus));
+}
+
+void Server::setExecArguments(const std::vector<std::string>& arguments) {
+    execArguments_ = arguments;
+}
+
+// Путь к программе по правилам execvp: имя без '/' ищется в PATH
+static std::string resolveExecutable(const std::string& name) {
+    if (name.find('/') != std::string::npos) {
+        return name;
+    }
+    const char* path = std::getenv("PATH");
+    std::istringstream directories(path ? path : "/usr/local/bin:/usr/bin:/bin");
+    std::string directory;
+    while (std::getline(directories, directory, ':')) {
+        std::string candidate = (directory.empty() ? "." : directory) + "/" + name;
+        if (access(candidate.c_str(), X_OK) == 0) {
+            return candidate;
+        }
+    }
+    return name;
+}
+
+bool Server::performUpgrade() {
+    if (execArguments_.empty()) {
+        logger_.error("Upgrade requested but server command line is unknown");
+        return false;
+    }
+    
+    logger_.info("Upgrade requested, starting new server process: " + execArguments_[0]);
+    
+    int channel = network_.openHandoffChannel(config_.upgradeSocket);
+    if (channel == -1) {
+        return false;
+    }
+    
+    // Между fork() и exec в потомке допустимы только async-signal-safe
+    // вызовы: другие потоки могли держать блокировки malloc и окружения,
+    // поэтому аргументы, путь и окружение собираются заранее
+    std::string program = resolveExecutable(execArguments_[0]);
+    std::vector<char*> args;
+    for (const auto& arg : execArguments_) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    
+    const std::string handoffPrefix = std::string(HANDOFF_ENV) + "=";
+    std::vector<std::string> environment;
+    for (char** entry = environ; *entry != nullptr; ++entry) {
+        if (strncmp(*entry, handoffPrefix.c_str(), handoffPrefix.size()) != 0) {
+            environment.push_back(*entry);
+        }
+    }
+    environment.push_back(handoffPrefix + config_.upgradeSocket);
+    std::vector<char*> envp;
+    for (auto& entry : environment) {
+        envp.push_back(&entry[0]);
+    }
+    envp.push_back(nullptr);
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        logger_.error("Failed to fork new server process: " + std::string(strerror(errno)));
+        close(channel);
+        unlink(config_.upgradeSocket.c_str());
+        return false;
+    }
+    
+    if (pid == 0) {
+        execve(program.c_str(), args.data(), envp.data());
+        _exit(127);
+    }
+    
+    if (!network_.handOffListeners(channel, config_.upgradeSocket, pid)) {
+        // Новый процесс не поднялся - продолжаем обслуживать клиентов сами
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        logger_.error("Upgrade aborted, continuing with current process");
+        return false;
+    }
+    
+    logger_.info("Upgrade completed, new server process pid=" + std::to_string(pid));
+    return true;
+}
+
 void Server::updateActivity() {
+    std::lock_guard<std::mutex> lock(activityMutex_);
     lastActivity_ = std::chrono::steady_clock::now();
 }
 
 bool Server::shouldShutdownDueToInactivity() {
+    // Рабочий процесс видит только свою часть подключений; простой
+    // одного процесса не означает простоя сервера
+    if (preforkWorker_) {
+        return false;
+    }
+    
+    // Пока идут сессии, сервер не простаивает
+    if (activeSessions() > 0) {
+        return false;
+    }
+    
     // Завершаем работу через 5 минут бездействия
     const auto timeout = std::chrono::minutes(5);
     auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(activityMutex_);
     auto elapsed = std::chrono::duration_cast<std::chrono::minutes>(now - lastActivity_);
     
     return elapsed >= timeout;
 }
 
+size_t Server::activeSessions() {
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    return activeSessions_;
+}
+
+void Server::waitForSessions() {
+    std::unique_lock<std::mutex> lock(sessionsMutex_);
+    if (activeSessions_ > 0) {
+        logger_.info("Draining " + std::to_string(activeSessions_) + " active client sessions");
+    }
+    sessionsChanged_.wait(lock, [this] { return activeSessions_ == 0; });
+}
+
+void Server::writeProfile() {
+    if (!profiler_.dump(config_.profileFile)) {
+        logger_.error("Failed to write profile " + config_.profileFile + ": " + strerror(errno));
+        return;
+    }
+    logger_.debug("Profile written to " + config_.profileFile + ", samples: " +
+                  std::to_string(profiler_.samples()) + ", dropped: " + std::to_string(profiler_.dropped()));
+}
+
+void Server::reportClientStats() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastStatsReport_ < CLIENT_STATS_INTERVAL) {
+        return;
+    }
+    lastStatsReport_ = now;
+    
+    if (!config_.profileFile.empty()) {
+        writeProfile();
+    }
+    
+    MemoryBudget::Stats memory = memory_.stats();
+    logger_.info("Memory stats: used=" + std::to_string(memory.used) +
+                 " peak=" + std::to_string(memory.peak) +
+                 " limit=" + std::to_string(memory.limit) +
+                 " waits=" + std::to_string(memory.waits) +
+                 " rejected=" + std::to_string(memory.rejected));
+    
+    if (IoStats::enabled()) {
+        uint64_t vectors = 0;
+        std::vector<IoCounters> stages = ioTotals(vectors);
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (!stages[i].empty()) {
+                logger_.info("I/O totals: stage=" + std::string(stageName(static_cast<SessionStage>(i))) +
+                             " vectors=" + std::to_string(vectors) + " " + stages[i].format());
+            }
+        }
+    }
+    
+    // В лог попадают только самые активные клиенты
+    const size_t maxClients = 10;
+    auto stats = scheduler_.snapshot();
+    for (size_t i = 0; i < stats.size() && i < maxClients; ++i) {
+        const auto& client = stats[i];
+        logger_.info("Client stats: key=" + client.key +
+                     " weight=" + std::to_string(client.weight) +
+                     " vectors=" + std::to_string(client.vectors) +
+                     " elements=" + std::to_string(client.elements) +
+                     " throttled=" + std::to_string(client.throttled) +
+                     " throttled_ms=" + std::to_string(client.throttledMicros / 1000) +
+                     " rejected=" + std::to_string(client.rejected) +
+                     " queued=" + std::to_string(client.queued));
+    }
+}
+
 void Server::run() {
     if (!initialize()) {
         throw ServerException("Failed to initialize server");
@@ -70,23 +456,66 @@ void Server::run() {
     
     // ВЫВОД СООБЩЕНИЯ О УСПЕШНОМ ЗАПУСКЕ
     std::cout << "Сервер запущен успешно" << std::endl;
-    std::cout << "Порт: " << config_.port << std::endl;
+    if (config_.tcpEnabled) {
+        std::cout << "Порт: " << config_.port << std::endl;
+    }
+    if (!config_.unixSocket.empty()) {
+        std::cout << "Unix-сокет: " << config_.unixSocket << std::endl;
+    }
+    if (config_.udpPort != 0) {
+        std::cout << "UDP-порт: " << config_.udpPort << std::endl;
+    }
     std::cout << "Файл базы клиентов: " << config_.clientDbFile << std::endl;
     std::cout << "Файл логов: " << config_.logFile << std::endl;
     std::cout << "Ожидание подключений..." << std::endl;
     std::cout << "Сервер автоматически завершит работу через 5 минут бездействия" << std::endl;
     
-    logger_.info("Server started and listening for connections on port " + 
-                 std::to_string(config_.port));
+    if (config_.tcpEnabled) {
+        logger_.info("Server started and listening for connections on port " + 
+                     std::to_string(config_.port));
+    }
+    if (!config_.unixSocket.empty()) {
+        logger_.info("Server started and listening for connections on Unix socket " +
+                     config_.unixSocket);
+    }
     logger_.info("Server will automatically shutdown after 5 minutes of inactivity");
     
+    // Привязка цикла приема подключений
+    if (!config_.acceptorCpus.empty()) {
+        if (pinCurrentThread(config_.acceptorCpus)) {
+            logger_.info("Accept loop pinned to CPUs " + formatCpuList(config_.acceptorCpus) +
+                         ", NUMA node " + std::to_string(currentNumaNode()));
+        } else {
+            logger_.warning("Failed to pin accept loop to CPUs " + formatCpuList(config_.acceptorCpus));
+        }
+    }
+    
     // Установка обработчиков сигналов
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
     std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGUSR2, upgradeSignalHandler);
+    
+    // Многопроцессный режим: главный процесс только следит за рабочими,
+    // рабочие процессы выходят из runMaster() и работают в цикле ниже
+    if (config_.processes > 1 && !runMaster()) {
+        network_.shutdown();
+        stop();
+        std::cout << "Сервер остановлен" << std::endl;
+        logger_.info("Server stopped");
+        return;
+    }
     
-    // ОДНОПОТОЧНЫЙ ЦИКЛ ОБРАБОТКИ
+    // ЦИКЛ ПРИЕМА ПОДКЛЮЧЕНИЙ (сессии обрабатываются в нем же при --max-sessions 1)
     while (running_ && g_running) {
+        // Горячий перезапуск: новые подключения принимает новый процесс,
+        // текущие сессии дорабатывают в этом процессе
+        if (g_upgradeRequested.exchange(false) && performUpgrade()) {
+            std::cout << "Сервер передал слушающий сокет новому процессу" << std::endl;
+            logger_.info("Server stopped accepting connections after upgrade");
+            break;
+        }
+        
         // Проверяем таймаут бездействия
         if (shouldShutdownDueToInactivity()) {
             std::cout << "Сервер завершает работу по таймауту бездействия (5 минут)" << std::endl;
@@ -99,14 +528,46 @@ void Server::run() {
         timeout.tv_sec = 1;  // 1 секунда таймаут для accept
         timeout.tv_usec = 0;
         
+        int tcpSocket = network_.getServerSocket();
+        int unixSocket = network_.getUnixSocket();
+        int udpSocket = network_.getUdpSocket();
+        
+        // При достижении лимита сессий новые подключения ждут в очереди listen();
+        // прокси держит соединения в отдельных потоках и лимитом не ограничен
+        if (!proxy_ && activeSessions() >= config_.maxSessions) {
+            tcpSocket = -1;
+            unixSocket = -1;
+        }
+        // При выводе из балансировки не принимаем и датаграммы
+        if (draining_) {
+            tcpSocket = -1;
+            unixSocket = -1;
+            udpSocket = -1;
+        }
+        
         fd_set readfds;
         FD_ZERO(&readfds);
-        FD_SET(network_.getServerSocket(), &readfds);
+        int maxSocket = -1;
+        if (tcpSocket != -1) {
+            FD_SET(tcpSocket, &readfds);
+            maxSocket = std::max(maxSocket, tcpSocket);
+        }
+        if (unixSocket != -1) {
+            FD_SET(unixSocket, &readfds);
+            maxSocket = std::max(maxSocket, unixSocket);
+        }
+        if (udpSocket != -1) {
+            FD_SET(udpSocket, &readfds);
+            maxSocket = std::max(maxSocket, udpSocket);
+        }
         
-        int result = select(network_.getServerSocket() + 1, &readfds, nullptr, nullptr, &timeout);
+        int result = select(maxSocket + 1, &readfds, nullptr, nullptr, &timeout);
+        
+        reportClientStats();
+        logger_.reportSuppressed();
         
         if (result < 0) {
-            if (running_) {
+            if (running_ && errno != EINTR) {
                 logger_.error("Error in select()");
             }
             continue;
@@ -115,46 +576,305 @@ void Server::run() {
             continue;
         }
         
-        // Есть подключение
-        std::string clientIP;
-        int clientSocket = network_.acceptClient(clientIP);
-        
-        if (clientSocket == -1) {
-            if (running_) {
-                logger_.error("Failed to accept client connection");
-            }
+        // Команда drain могла прийти, пока шло ожидание
+        if (draining_) {
             continue;
         }
         
-        // Обновляем время активности
-        updateActivity();
+        // --lazy-init: первое подключение ждет загрузки базы и запуска пула
+        if (!ready_ && !completeInitialization()) {
+            logger_.error("Server cannot serve clients, shutting down");
+            break;
+        }
         
-        // Логируем подключение клиента
-        logger_.info("New client connection from: " + clientIP);
+        // Есть подключение - обслуживаем каждый готовый слушающий сокет
+        if (tcpSocket != -1 && FD_ISSET(tcpSocket, &readfds)) {
+            serveConnection(tcpSocket);
+        }
+        if (unixSocket != -1 && FD_ISSET(unixSocket, &readfds)) {
+            serveConnection(unixSocket);
+        }
+        if (udpSocket != -1 && FD_ISSET(udpSocket, &readfds)) {
+            if (udp_.processPending(udpSocket) > 0) {
+                updateActivity();
+            }
+        }
+    }
+    
+    if (udp_.processed() + udp_.rejected() > 0) {
+        logger_.info("UDP datagrams processed: " + std::to_string(udp_.processed()) +
+                     ", rejected: " + std::to_string(udp_.rejected()));
+    }
+    
+    // Новые подключения больше не принимаются, текущие сессии дорабатывают
+    network_.shutdown();
+    waitForSessions();
+    admin_.stop();
+    if (proxy_) {
+        proxy_->stop();
+    }
+    if (!config_.profileFile.empty()) {
+        profiler_.stop();
+        writeProfile();
+    }
+    
+    stop();
+    std::cout << "Сервер остановлен" << std::endl;
+    logger_.info("Server stopped");
+}
+
+bool Server::runMaster() {
+    // Горячий перезапуск в многопроцессном режиме не поддерживается
+    std::signal(SIGUSR2, SIG_IGN);
+    
+    const auto restartDelay = std::chrono::seconds(1);
+    std::vector<pid_t> children(config_.processes, 0);
+    std::vector<std::chrono::steady_clock::time_point> startedAt(config_.processes);
+    std::vector<std::chrono::steady_clock::time_point> restartAt(config_.processes);
+    
+    std::cout << "Рабочих процессов: " << config_.processes << std::endl;
+    logger_.info("Prefork master pid=" + std::to_string(getpid()) + " starting " +
+                 std::to_string(config_.processes) + " worker processes");
+    
+    while (g_running) {
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (children[i] != 0 || now < restartAt[i]) {
+                continue;
+            }
+            
+            // Буфер лога сбрасывается, иначе его содержимое запишут оба процесса
+            logger_.flush();
+            pid_t pid = fork();
+            if (pid == 0) {
+                preforkWorker_ = true;
+                startWorkerPool();
+                logger_.info("Worker process " + std::to_string(i) + " started, pid=" +
+                             std::to_string(getpid()));
+                return true;
+            }
+            if (pid < 0) {
+                logger_.error("Failed to fork worker process: " + std::string(strerror(errno)));
+                restartAt[i] = now + restartDelay;
+                continue;
+            }
+            children[i] = pid;
+            startedAt[i] = now;
+        }
         
-        try {
-            // ОБРАБОТКА КЛИЕНТА В ОСНОВНОМ ПОТОКЕ
-            handleClient(clientSocket, clientIP);
-        } catch (const std::exception& e) {
-            logger_.error("Exception in client handling: " + std::string(e.what()));
-        } catch (...) {
-            logger_.error("Unknown exception in client handling");
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid <= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            continue;
         }
         
-        // Закрываем соединение после обработки
-        network_.closeClient(clientSocket);
-        logger_.info("Client disconnected: " + clientIP);
+        auto slot = std::find(children.begin(), children.end(), pid);
+        if (slot == children.end()) {
+            continue;
+        }
+        size_t index = slot - children.begin();
+        *slot = 0;
         
-        // Обновляем время активности после обработки клиента
-        updateActivity();
+        if (WIFSIGNALED(status)) {
+            logger_.error("Worker process " + std::to_string(index) + " (pid " + std::to_string(pid) +
+                          ") killed by signal " + std::to_string(WTERMSIG(status)) + ", restarting");
+        } else {
+            logger_.warning("Worker process " + std::to_string(index) + " (pid " + std::to_string(pid) +
+                            ") exited with status " + std::to_string(WEXITSTATUS(status)) + ", restarting");
+        }
         
-        // Логируем готовность к следующему подключению
-        logger_.info("Ready for next client connection...");
+        // Процесс, падающий сразу после запуска, перезапускается с задержкой
+        now = std::chrono::steady_clock::now();
+        restartAt[index] = now - startedAt[index] < restartDelay ? now + restartDelay : now;
     }
     
-    stop();
-    std::cout << "Сервер остановлен" << std::endl;
-    logger_.info("Server stopped");
+    logger_.info("Stopping worker processes");
+    for (pid_t child : children) {
+        if (child != 0) {
+            kill(child, SIGTERM);
+        }
+    }
+    for (pid_t child : children) {
+        if (child != 0) {
+            waitpid(child, nullptr, 0);
+        }
+    }
+    return false;
+}
+
+void Server::serveConnection(int listenSocket) {
+    std::string clientIP;
+    int clientSocket = network_.acceptClient(listenSocket, clientIP);
+    
+    if (clientSocket == -1) {
+        // Подключение забрал другой рабочий процесс
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        }
+        if (running_) {
+            logger_.error("Failed to accept client connection");
+        }
+        return;
+    }
+    
+    // Обновляем время активности
+    updateActivity();
+    
+    // Логируем подключение клиента
+    logger_.logf(LogLevel::INFO, LogFormat::NEW_CLIENT_CONNECTION, {clientIP});
+    
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        activeSessions_++;
+    }
+    
+    if (config_.maxSessions <= 1 && !proxy_) {
+        // ОБРАБОТКА КЛИЕНТА В ОСНОВНОМ ПОТОКЕ
+        runSession(network_, clientSocket, clientIP);
+        return;
+    }
+    
+    try {
+        std::thread([this, clientSocket, clientIP] {
+            nameCurrentThread("vcalc-session");
+            pinSessionThread(clientSocket);
+            runSession(network_, clientSocket, clientIP);
+        }).detach();
+    } catch (const std::system_error& e) {
+        logger_.error("Failed to start session thread: " + std::string(e.what()));
+        runSession(network_, clientSocket, clientIP);
+    }
+}
+
+void Server::pinSessionThread(int clientSocket) {
+    if (config_.ioCpus.empty()) {
+        return;
+    }
+    
+    // Если пакеты соединения приходят на процессор из списка (RSS),
+    // сессия работает там же - данные уже в его кэше
+    CpuList cpus = config_.ioCpus;
+    int incomingCpu = network_.getIncomingCpu(clientSocket);
+    if (std::find(cpus.begin(), cpus.end(), incomingCpu) != cpus.end()) {
+        cpus.assign(1, incomingCpu);
+    }
+    
+    if (!pinCurrentThread(cpus)) {
+        logger_.warning("Failed to pin session thread to CPUs " + formatCpuList(cpus));
+    }
+}
+
+void Server::runSession(Transport& transport, int clientSocket, const std::string& clientIP) {
+    auto session = std::make_shared<SessionInfo>();
+    session->clientIP = clientIP;
+    session->started = std::chrono::steady_clock::now();
+    session->memory.reset(new MemoryBudget::Account(memory_));
+    // Пара сокетов встроенного режима и Unix-сокет тоже локальные
+    session->quickAck = config_.tcp.quickAck && !network_.isLocalConnection(clientSocket);
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        session->id = nextSessionId_++;
+        sessions_[session->id] = session;
+    }
+    
+    // С --capture принятые байты сессии пишутся в файл для vcalc-replay;
+    // номер сессии включает pid, чтобы различать рабочие процессы
+    std::unique_ptr<CaptureTransport> captured;
+    if (capture_) {
+        captured.reset(new CaptureTransport(transport, *capture_,
+                                            static_cast<uint64_t>(getpid()) << 32 | session->id));
+    }
+    Transport& sessionTransport = captured ? static_cast<Transport&>(*captured) : transport;
+    session->ioMark = IoStats::current();
+    
+    try {
+        if (proxy_) {
+            enterStage(*session, SessionStage::PROXIED);
+            proxy_->relay(clientSocket, clientIP);
+        } else {
+            handleClient(sessionTransport, clientSocket, clientIP, *session);
+        }
+    } catch (const std::exception& e) {
+        logger_.error("Exception in client handling: " + std::string(e.what()));
+    } catch (...) {
+        logger_.error("Unknown exception in client handling");
+    }
+    
+    // Закрываем соединение после обработки
+    sessionTransport.closeClient(clientSocket);
+    logger_.logf(LogLevel::INFO, LogFormat::CLIENT_DISCONNECTED, {clientIP});
+    finishSessionIo(*session);
+    
+    // Обновляем время активности после обработки клиента
+    updateActivity();
+    
+    // Логируем готовность к следующему подключению
+    logger_.logf(LogLevel::INFO, LogFormat::READY_FOR_NEXT_CLIENT);
+    
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    sessions_.erase(session->id);
+    activeSessions_--;
+    sessionsChanged_.notify_all();
+}
+
+void Server::enterStage(SessionInfo& session, SessionStage stage) {
+    // Все, что поток сессии сделал с начала прошлого этапа, относится к нему
+    chargeIo(session, session.stage.load(std::memory_order_relaxed), session.ioMark);
+    session.stage.store(stage, std::memory_order_relaxed);
+}
+
+void Server::expectRequest(int clientSocket, SessionInfo& session) {
+    if (session.quickAck && !network_.rearmQuickAck(clientSocket)) {
+        logger_.warning("Failed to set TCP_QUICKACK for " + session.clientIP + ": " + strerror(errno));
+        session.quickAck = false;
+    }
+}
+
+void Server::chargeIo(SessionInfo& session, SessionStage stage, IoCounters& mark) {
+    if (!IoStats::enabled()) {
+        return;
+    }
+    IoCounters now = IoStats::current();
+    std::lock_guard<std::mutex> lock(session.ioMutex);
+    session.io[static_cast<size_t>(stage)].add(now.since(mark));
+    mark = now;
+}
+
+void Server::finishSessionIo(SessionInfo& session) {
+    if (!IoStats::enabled()) {
+        return;
+    }
+    chargeIo(session, session.stage.load(std::memory_order_relaxed), session.ioMark);
+    
+    uint64_t vectors = session.vectors.load(std::memory_order_relaxed);
+    IoCounters total = {};
+    {
+        std::lock_guard<std::mutex> totalsLock(ioMutex_);
+        std::lock_guard<std::mutex> lock(session.ioMutex);
+        for (size_t i = 0; i < static_cast<size_t>(SessionStage::STAGE_COUNT); ++i) {
+            ioTotals_[i].add(session.io[i]);
+            total.add(session.io[i]);
+        }
+        ioSessions_++;
+        ioVectors_ += vectors;
+    }
+    
+    // Строки пишутся после подсчета и в счетчики сессии уже не попадают
+    std::string prefix = "I/O stats: session=" + std::to_string(session.id) + " client=" + session.clientIP;
+    for (size_t i = 0; i < static_cast<size_t>(SessionStage::STAGE_COUNT); ++i) {
+        if (!session.io[i].empty()) {
+            logger_.info(prefix + " stage=" + stageName(static_cast<SessionStage>(i)) + " " +
+                         session.io[i].format());
+        }
+    }
+    logger_.info(prefix + " stage=total vectors=" + std::to_string(vectors) + " " + total.format());
+}
+
+std::vector<IoCounters> Server::ioTotals(uint64_t& vectors) {
+    std::lock_guard<std::mutex> lock(ioMutex_);
+    vectors = ioVectors_;
+    return std::vector<IoCounters>(std::begin(ioTotals_), std::end(ioTotals_));
 }
 
 void Server::stop() {
@@ -165,70 +885,374 @@ void Server::stop() {
     }
 }
 
-// Функция для проверки переполнения при умножении
-bool checkMultiplicationOverflow(float a, float b) {
-    if (a == 0.0f || b == 0.0f) {
-        return false;
+void Server::handleSharedMemorySession(int clientSocket, const std::string& clientIP,
+                                       const std::string& clientKey, SessionInfo& session) {
+    // Кольца передаются через SCM_RIGHTS, поэтому режим доступен только по Unix-сокету
+    uint32_t reply = 0;
+    if (!network_.isLocalConnection(clientSocket)) {
+        logger_.warning("Shared memory mode requested over non-local connection from " + clientIP);
+        network_.sendData(clientSocket, &reply, sizeof(reply));
+        return;
     }
     
-    float max_value = std::numeric_limits<float>::max();
-    float min_value = std::numeric_limits<float>::lowest();
+    // Два кольца занимают память, пока сессия не закончится
+    MemoryBudget::Reservation rings(*session.memory, 2 * SHM_RING_CAPACITY);
+    if (!rings) {
+        logger_.warning("Memory budget exhausted, shared memory mode refused for " + clientIP);
+        network_.sendData(clientSocket, &reply, sizeof(reply));
+        return;
+    }
     
-    // Проверка переполнения вверх (a * b > max_value)
-    if (a > 0 && b > 0) {
-        return a > max_value / b;
+    ShmChannel channel;
+    if (!channel.create(SHM_RING_CAPACITY)) {
+        logger_.error("Failed to create shared memory channel: " + std::string(strerror(errno)));
+        network_.sendData(clientSocket, &reply, sizeof(reply));
+        return;
     }
-    // Проверка переполнения вниз (a * b < min_value)  
-    else if (a < 0 && b < 0) {
-        return a < max_value / b;
+    
+    // Кольца забирают индексы до того, как память увидит клиент
+    ShmRing requests = channel.requestRing();
+    ShmRing responses = channel.responseRing();
+    
+    reply = htole32(static_cast<uint32_t>(channel.ringCapacity()));
+    if (!network_.sendDescriptors(clientSocket, &reply, sizeof(reply),
+                                  {channel.memFd(), channel.serverEvent(), channel.clientEvent()})) {
+        return;
     }
-    // Проверка отрицательного переполнения
-    else if (a > 0 && b < 0) {
-        return b < min_value / a;
+    
+    logger_.info("Shared memory session started for " + clientIP + ", ring capacity " +
+                 std::to_string(channel.ringCapacity()) + " bytes");
+    
+    const int idleTimeoutMs = 10000;
+    uint64_t processed = 0;
+    
+    while (true) {
+        uint32_t payloadSize = 0;
+        uint32_t tag = 0;
+        const void* payload = requests.front(payloadSize, tag);
+        
+        if (payload == nullptr) {
+            if (!requests.corrupted() && requests.waitReadable(clientSocket, idleTimeoutMs)) {
+                continue;
+            }
+            if (requests.corrupted()) {
+                logger_.error("Shared memory client corrupted the request ring, closing session with " +
+                              clientIP);
+            } else {
+                logger_.info("Shared memory client closed connection or went idle");
+            }
+            break;
+        }
+        
+        // Пустая запись - клиент завершает сессию
+        if (payloadSize == 0) {
+            requests.pop();
+            break;
+        }
+        
+        uint32_t vectorSize = payloadSize / sizeof(float);
+        if (payloadSize % sizeof(float) != 0 || vectorSize > MAX_VECTOR_SIZE) {
+            logger_.error("Invalid shared memory record size: " + std::to_string(payloadSize));
+            break;
+        }
+        
+        scheduler_.admit(clientKey, vectorSize);
+        
+        // Данные читаются прямо из кольца, в порядке байтов хоста
+        float product = calculateProductWithOverflowCheck(static_cast<const float*>(payload),
+                                                          vectorSize, logger_);
+        requests.pop();
+        
+        void* slot = responses.reserve(sizeof(product));
+        if (slot == nullptr) {
+            if (responses.waitWritable(sizeof(product), clientSocket, idleTimeoutMs)) {
+                slot = responses.reserve(sizeof(product));
+            }
+        }
+        if (slot == nullptr) {
+            logger_.error(responses.corrupted()
+                          ? "Shared memory client corrupted the response ring, closing session with " + clientIP
+                          : "Shared memory client stopped reading results");
+            break;
+        }
+        
+        memcpy(slot, &product, sizeof(product));
+        responses.publish(sizeof(product), tag);
+        processed++;
+        session.vectors.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    logger_.info("Shared memory session finished for " + clientIP + ", vectors processed: " +
+                 std::to_string(processed));
+}
+
+void Server::handleTaggedSession(Transport& transport, int clientSocket, const std::string& clientIP,
+                                 const std::string& clientKey, SessionInfo& info) {
+    logger_.info("Tagged session started for " + clientIP);
+    MemoryBudget::Account& memory = *info.memory;
+    
+    TaggedSession session;
+    uint64_t submitted = 0;
+    bool clean = false;
+    
+    while (true) {
+        expectRequest(clientSocket, info);
+        uint32_t header[2];
+        if (!transport.receiveData(clientSocket, header, sizeof(header))) {
+            logger_.error("Failed to receive tagged request header from " + clientIP);
+            break;
+        }
+        
+        uint32_t requestId = le32toh(header[0]);
+        uint32_t vectorSize = le32toh(header[1]);
+        
+        // Нулевой размер - клиент больше ничего не пришлет
+        if (vectorSize == 0) {
+            clean = true;
+            break;
+        }
+        
+        if (vectorSize > MAX_TAGGED_VECTOR_SIZE) {
+            logger_.error("Invalid tagged vector size: " + std::to_string(vectorSize));
+            break;
+        }
+        
+        // Ограничение скорости: пока токенов нет, данные из сокета не читаются
+        scheduler_.admit(clientKey, vectorSize);
+        
+        // Память вектора возвращает задача пула после вычисления. Пока
+        // ее нет, вектор остается в сокете: клиент упрется в TCP-окно
+        uint64_t vectorBytes = static_cast<uint64_t>(vectorSize) * sizeof(float);
+        if (!memory.acquire(vectorBytes)) {
+            logger_.error("Memory budget exhausted, tagged session aborted for " + clientIP);
+            break;
+        }
+        
+        // Вектор читается целиком одним вызовом, а не по элементу
+        auto vector = std::make_shared<std::vector<float>>(vectorSize);
+        if (!transport.receiveData(clientSocket, vector->data(), vectorBytes)) {
+            logger_.error("Failed to receive tagged request " + std::to_string(requestId));
+            memory.release(vectorBytes);
+            break;
+        }
+        
+        for (float& value : *vector) {
+            uint32_t temp;
+            memcpy(&temp, &value, sizeof(float));
+            temp = le32toh(temp);
+            memcpy(&value, &temp, sizeof(float));
+        }
+        
+        {
+            std::unique_lock<std::mutex> lock(session.stateMutex);
+            session.changed.wait(lock, [&session] {
+                return session.inFlight < MAX_TAGGED_IN_FLIGHT || session.failed;
+            });
+            if (session.failed) {
+                memory.release(vectorBytes);
+                break;
+            }
+            session.inFlight++;
+        }
+        
+        logger_.logf(LogLevel::DEBUG, LogFormat::TAGGED_REQUEST, {requestId, vectorSize});
+        
+        scheduler_.submit(*workers_, clientKey, vectorSize,
+                          [this, &transport, &session, &info, &memory, clientSocket, requestId, vector, vectorBytes] {
+            // Вычисление и отправка идут в потоке пула, но относятся к этой сессии
+            IoCounters mark = IoStats::current();
+            float product = calculateProductWithOverflowCheck(*vector, logger_);
+            memory.release(vectorBytes);
+            chargeIo(info, SessionStage::COMPUTING, mark);
+            
+            uint32_t bits;
+            memcpy(&bits, &product, sizeof(bits));
+            uint32_t reply[2] = {htole32(requestId), htole32(bits)};
+            
+            bool sent;
+            {
+                std::lock_guard<std::mutex> sendLock(session.sendMutex);
+                sent = transport.sendData(clientSocket, reply, sizeof(reply));
+            }
+            chargeIo(info, SessionStage::SENDING, mark);
+            info.vectors.fetch_add(1, std::memory_order_relaxed);
+            
+            std::lock_guard<std::mutex> lock(session.stateMutex);
+            if (!sent) {
+                session.failed = true;
+            }
+            session.inFlight--;
+            session.changed.notify_all();
+        });
+        submitted++;
     }
-    else if (a < 0 && b > 0) {
-        return a < min_value / b;
+    
+    // Дожидаемся всех задач: они используют сокет и состояние сессии
+    {
+        std::unique_lock<std::mutex> lock(session.stateMutex);
+        session.changed.wait(lock, [&session] { return session.inFlight == 0; });
     }
     
-    return false;
+    logger_.info("Tagged session " + std::string(clean ? "completed" : "aborted") + " for " + clientIP +
+                 ", requests: " + std::to_string(submitted) +
+                 (session.failed ? ", failed to deliver some results" : ""));
 }
 
-// Функция для вычисления произведения с проверкой переполнения
-float calculateProductWithOverflowCheck(const std::vector<float>& vector, Logger& logger) {
-    if (vector.empty()) {
-        return 0.0f;
+void Server::handleFramedSession(Transport& transport, int clientSocket, const std::string& clientIP,
+                                 const std::string& clientKey, SessionInfo& session) {
+    uint32_t hello[2] = {htole32(FRAMED_PROTOCOL_VERSION), htole32(FRAMED_SUPPORTED_FLAGS)};
+    if (!transport.sendData(clientSocket, hello, sizeof(hello))) {
+        logger_.error("Failed to send protocol v2 parameters to " + clientIP);
+        return;
     }
+    logger_.info("Framed session (protocol v2) started for " + clientIP);
     
-    float product = 1.0f;
+    // Буферы растут до размера самого большого пакета и переиспользуются.
+    // Элементы хранятся в uint64_t, чтобы векторы любого типа были выровнены.
+    std::vector<uint32_t> sizes;
+    std::vector<uint8_t> payload;
+    std::vector<uint64_t> elements;
+    std::vector<uint8_t> shuffled;  // Промежуточный буфер распаковки
+    std::vector<uint8_t> reply;
+    uint64_t batches = 0;
+    // Буферы не отдают память между пакетами, поэтому резерв только растет
+    uint64_t reserved = 0;
     
-    for (size_t i = 0; i < vector.size(); ++i) {
-        float value = vector[i];
+    while (true) {
+        enterStage(session, SessionStage::WAITING);
+        expectRequest(clientSocket, session);
+        uint32_t header[3];
+        if (!transport.receiveData(clientSocket, header, sizeof(header))) {
+            logger_.error("Failed to receive framed batch header from " + clientIP);
+            return;
+        }
+        
+        uint32_t count = le32toh(header[0]);
+        uint32_t flags = le32toh(header[1]);
+        uint32_t payloadBytes = le32toh(header[2]);
+        
+        // Пустой пакет - клиент завершает сессию
+        if (count == 0) {
+            break;
+        }
+        
+        uint32_t typeCode = (flags & FRAMED_TYPE_MASK) >> FRAMED_TYPE_SHIFT;
+        if (count > MAX_FRAMED_VECTORS || (flags & ~(FRAMED_SUPPORTED_FLAGS | FRAMED_TYPE_MASK)) != 0 ||
+            typeCode >= static_cast<uint32_t>(ElementType::TYPE_COUNT)) {
+            logger_.error("Invalid framed batch header: vectors=" + std::to_string(count) +
+                          " flags=" + std::to_string(flags));
+            return;
+        }
+        ElementType type = static_cast<ElementType>(typeCode);
+        size_t width = elementWidth(type);
+        size_t productWidth = resultWidth(type);
+        
+        enterStage(session, SessionStage::RECEIVING);
+        sizes.resize(count);
+        if (!transport.receiveData(clientSocket, sizes.data(), count * sizeof(uint32_t))) {
+            logger_.error("Failed to receive framed vector sizes from " + clientIP);
+            return;
+        }
+        
+        uint64_t totalElements = 0;
+        for (uint32_t& size : sizes) {
+            size = le32toh(size);
+            if (size == 0 || size > MAX_TAGGED_VECTOR_SIZE) {
+                logger_.error("Invalid framed vector size: " + std::to_string(size));
+                return;
+            }
+            totalElements += size;
+        }
         
-        // Проверка на переполнение перед умножением
-        if (checkMultiplicationOverflow(product, value)) {
-            logger.warning("Overflow detected in vector product calculation");
-            return -std::numeric_limits<float>::infinity(); // -inf согласно ТЗ
+        // Несжатые данные обязаны совпадать по длине с суммой размеров,
+        // сжатые не могут быть больше верхней оценки кодека
+        uint64_t rawBytes = totalElements * width;
+        bool compressed = (flags & FRAMED_FLAG_LZ) != 0;
+        if (totalElements > MAX_FRAMED_ELEMENTS ||
+            (!compressed && payloadBytes != rawBytes) ||
+            (compressed && payloadBytes > rawBytes + rawBytes / 255 + 16)) {
+            logger_.error("Invalid framed batch size: elements=" + std::to_string(totalElements) +
+                          " payload=" + std::to_string(payloadBytes));
+            return;
         }
         
-        product *= value;
+        bool withStatus = (flags & FRAMED_FLAG_STATUS) != 0;
+        size_t maskBytes = withStatus ? overflowMaskBytes(count) : 0;
+        // Сжатый пакет распаковывается через промежуточный буфер того же размера
+        uint64_t needed = payloadBytes + rawBytes + (compressed ? rawBytes : 0) +
+                          sizeof(uint32_t) + maskBytes + count * productWidth;
+        if (needed > reserved) {
+            if (!session.memory->acquire(needed - reserved)) {
+                logger_.error("Memory budget exhausted, framed batch of " + std::to_string(payloadBytes) +
+                              " bytes rejected for " + clientIP);
+                return;
+            }
+            reserved = needed;
+        }
         
-        // Проверка на переполнение после умножения
-        if (std::isinf(product)) {
-            logger.warning("Overflow occurred in vector product calculation");
-            return -std::numeric_limits<float>::infinity(); // -inf согласно ТЗ
+        payload.resize(payloadBytes);
+        if (!transport.receiveData(clientSocket, payload.data(), payloadBytes)) {
+            logger_.error("Failed to receive framed batch payload from " + clientIP);
+            return;
         }
+        
+        elements.resize((rawBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        uint8_t* data = reinterpret_cast<uint8_t*>(elements.data());
+        if (compressed) {
+            if (!decompressElements(payload.data(), payload.size(), data, totalElements, width, shuffled)) {
+                logger_.error("Corrupted compressed batch from " + clientIP);
+                return;
+            }
+        } else {
+            memcpy(data, payload.data(), rawBytes);
+        }
+        
+        if (type == ElementType::FLOAT32) {
+            logger_.logf(LogLevel::INFO, LogFormat::FRAMED_BATCH, {count, totalElements, payloadBytes});
+        } else {
+            logger_.logf(LogLevel::INFO, LogFormat::FRAMED_TYPED_BATCH,
+                         {count, elementTypeName(type), totalElements, payloadBytes});
+        }
+        
+        // Элементы и произведения остаются little-endian: порядок байтов
+        // учитывает calculateProduct
+        enterStage(session, SessionStage::COMPUTING);
+        reply.resize(sizeof(uint32_t) + maskBytes + count * productWidth);
+        uint32_t replyCount = htole32(count);
+        memcpy(reply.data(), &replyCount, sizeof(replyCount));
+        uint8_t* mask = reply.data() + sizeof(uint32_t);
+        memset(mask, 0, maskBytes);
+        const uint8_t* vector = data;
+        uint8_t* result = mask + maskBytes;
+        for (uint32_t i = 0; i < count; ++i) {
+            scheduler_.admit(clientKey, sizes[i]);
+            // Маска little-endian: бит i % 32 слова i / 32 - это бит i % 8 байта i / 8
+            if (!calculateProduct(type, vector, sizes[i], result, logger_) && withStatus) {
+                mask[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+            }
+            vector += sizes[i] * width;
+            result += productWidth;
+        }
+        
+        enterStage(session, SessionStage::SENDING);
+        if (!transport.sendData(clientSocket, reply.data(), reply.size())) {
+            logger_.error("Failed to send framed batch results to " + clientIP);
+            return;
+        }
+        session.vectors.fetch_add(count, std::memory_order_relaxed);
+        batches++;
     }
     
-    return product;
+    logger_.info("Framed session completed for " + clientIP + ", batches: " + std::to_string(batches));
 }
 
-void Server::handleClient(int clientSocket, const std::string& clientIP) {
-    logger_.info("=== START handling client: " + clientIP + " ===");
+void Server::handleClient(Transport& transport, int clientSocket, const std::string& clientIP, SessionInfo& session) {
+    logger_.logf(LogLevel::INFO, LogFormat::START_HANDLING, {clientIP});
     
     try {
         // Получение и аутентификация логина
         std::string login;
-        if (!network_.receiveLogin(clientSocket, login)) {
+        if (!transport.receiveLogin(clientSocket, login)) {
             logger_.error("Failed to receive login from " + clientIP);
             return;
         }
@@ -238,55 +1262,92 @@ void Server::handleClient(int clientSocket, const std::string& clientIP) {
             logger_.warning("Unexpected login from " + clientIP + ": " + login + " (expected: user)");
         }
         
-        if (!authenticator_.authenticateUser(clientSocket, login)) {
+        if (!authenticator_.authenticateUser(transport, clientSocket, login)) {
             logger_.warning("Authentication failed for " + clientIP + " user: " + login);
             return;
         }
         
-        logger_.info("Authentication successful for user: " + login);
+        logger_.logf(LogLevel::INFO, LogFormat::AUTH_SUCCESS, {login});
+        
+        // Ключ для ограничения скорости и справедливой очереди
+        const std::string clientKey = config_.fairnessByLogin ? login : clientIP;
         
         // Получаем количество векторов
+        enterStage(session, SessionStage::WAITING);
+        expectRequest(clientSocket, session);
         uint32_t numVectors;
-        logger_.debug("Waiting for number of vectors...");
-        if (!network_.receiveData(clientSocket, &numVectors, sizeof(numVectors))) {
+        logger_.logf(LogLevel::DEBUG, LogFormat::WAITING_NUM_VECTORS);
+        if (!transport.receiveData(clientSocket, &numVectors, sizeof(numVectors))) {
             logger_.error("Failed to receive number of vectors");
             return;
         }
         
         numVectors = le32toh(numVectors);
-        logger_.info("Number of vectors: " + std::to_string(numVectors));
         
-        if (numVectors == 0 || numVectors > 100) {
+        if (numVectors == PROTOCOL_MODE_SHM) {
+            enterStage(session, SessionStage::SHARED_MEMORY);
+            handleSharedMemorySession(clientSocket, clientIP, clientKey, session);
+            logger_.logf(LogLevel::INFO, LogFormat::COMPLETED_HANDLING, {clientIP});
+            return;
+        }
+        
+        if (numVectors == PROTOCOL_MODE_FRAMED) {
+            handleFramedSession(transport, clientSocket, clientIP, clientKey, session);
+            logger_.logf(LogLevel::INFO, LogFormat::COMPLETED_HANDLING, {clientIP});
+            return;
+        }
+        
+        if (numVectors == PROTOCOL_MODE_TAGGED) {
+            enterStage(session, SessionStage::TAGGED);
+            handleTaggedSession(transport, clientSocket, clientIP, clientKey, session);
+            logger_.logf(LogLevel::INFO, LogFormat::COMPLETED_HANDLING, {clientIP});
+            return;
+        }
+        
+        logger_.logf(LogLevel::INFO, LogFormat::NUMBER_OF_VECTORS, {numVectors});
+        
+        if (numVectors == 0 || numVectors > MAX_VECTORS_PER_SESSION) {
             logger_.error("Invalid number of vectors: " + std::to_string(numVectors));
             return;
         }
         
         // Обрабатываем каждый вектор и сразу отправляем результат
         for (uint32_t i = 0; i < numVectors; ++i) {
-            logger_.info("Processing vector " + std::to_string(i + 1));
+            logger_.logf(LogLevel::INFO, LogFormat::PROCESSING_VECTOR, {i + 1});
             
             // Получаем размер текущего вектора
+            enterStage(session, SessionStage::RECEIVING);
+            expectRequest(clientSocket, session);
             uint32_t vectorSize;
-            logger_.debug("Waiting for size of vector " + std::to_string(i + 1));
-            if (!network_.receiveData(clientSocket, &vectorSize, sizeof(vectorSize))) {
+            logger_.logf(LogLevel::DEBUG, LogFormat::WAITING_VECTOR_SIZE, {i + 1});
+            if (!transport.receiveData(clientSocket, &vectorSize, sizeof(vectorSize))) {
                 logger_.error("Failed to receive size for vector " + std::to_string(i + 1));
                 return;
             }
             
             vectorSize = le32toh(vectorSize);
-            logger_.info("Vector " + std::to_string(i + 1) + " size: " + std::to_string(vectorSize));
+            logger_.logf(LogLevel::INFO, LogFormat::VECTOR_SIZE, {i + 1, vectorSize});
             
-            if (vectorSize == 0 || vectorSize > 1000) {
+            if (vectorSize == 0 || vectorSize > MAX_VECTOR_SIZE) {
                 logger_.error("Invalid vector size: " + std::to_string(vectorSize));
                 return;
             }
             
+            scheduler_.admit(clientKey, vectorSize);
+            
+            MemoryBudget::Reservation reservation(*session.memory, vectorSize * sizeof(float));
+            if (!reservation) {
+                logger_.error("Memory budget exhausted, rejecting vector " + std::to_string(i + 1) +
+                              " from " + clientIP);
+                return;
+            }
+            
             // Получаем данные вектора
             std::vector<float> vector(vectorSize);
             
             for (uint32_t j = 0; j < vectorSize; ++j) {
                 float value;
-                if (!network_.receiveData(clientSocket, &value, sizeof(value))) {
+                if (!transport.receiveData(clientSocket, &value, sizeof(value))) {
                     logger_.error("Failed to receive vector " + std::to_string(i + 1) + " element " + std::to_string(j));
                     return;
                 }
@@ -297,42 +1358,40 @@ void Server::handleClient(int clientSocket, const std::string& clientIP) {
                 memcpy(&value, &temp, sizeof(float));
                 
                 vector[j] = value;
-                logger_.debug("Vector " + std::to_string(i + 1) + " element " + std::to_string(j) + ": " + std::to_string(value));
+                logger_.logf(LogLevel::DEBUG, LogFormat::VECTOR_ELEMENT, {i + 1, j, value});
             }
             
             // Логируем весь вектор
-            std::string debugMsg = "Vector " + std::to_string(i + 1) + " data: [";
-            for (size_t j = 0; j < vector.size(); ++j) {
-                if (j > 0) debugMsg += ", ";
-                debugMsg += std::to_string(vector[j]);
-            }
-            debugMsg += "]";
-            logger_.info(debugMsg);
+            logger_.logf(LogLevel::INFO, LogFormat::VECTOR_DATA,
+                         {i + 1, LogArg::floats(vector.data(), vector.size())});
             
+            enterStage(session, SessionStage::COMPUTING);
             float product = calculateProductWithOverflowCheck(vector, logger_);
             
             if (std::isinf(product)) {
-                logger_.info("Vector " + std::to_string(i + 1) + " product: -inf (OVERFLOW)");
+                logger_.logf(LogLevel::INFO, LogFormat::VECTOR_OVERFLOW, {i + 1});
             } else {
-                logger_.info("Vector " + std::to_string(i + 1) + " product: " + std::to_string(product));
+                logger_.logf(LogLevel::INFO, LogFormat::VECTOR_PRODUCT, {i + 1, product});
             }
             
-            logger_.debug("Sending result for vector " + std::to_string(i + 1) + ": " + std::to_string(product));
+            logger_.logf(LogLevel::DEBUG, LogFormat::SENDING_RESULT, {i + 1, product});
             
             // Конвертируем результат в little-endian
+            enterStage(session, SessionStage::SENDING);
             uint32_t temp;
             memcpy(&temp, &product, sizeof(float));
             temp = htole32(temp);
             
-            if (!network_.sendData(clientSocket, &temp, sizeof(temp))) {
+            if (!transport.sendData(clientSocket, &temp, sizeof(temp))) {
                 logger_.error("Failed to send result for vector " + std::to_string(i + 1));
                 return;
             }
             
-            logger_.info("Successfully sent result for vector " + std::to_string(i + 1));
+            logger_.logf(LogLevel::INFO, LogFormat::RESULT_SENT, {i + 1});
+            session.vectors.fetch_add(1, std::memory_order_relaxed);
         }
         
-        logger_.info("Completed processing all " + std::to_string(numVectors) + " vectors");
+        logger_.logf(LogLevel::INFO, LogFormat::COMPLETED_VECTORS, {numVectors});
         
     } catch (const std::exception& e) {
         logger_.error("Exception while handling client " + clientIP + ": " + e.what());
@@ -342,7 +1401,201 @@ void Server::handleClient(int clientSocket, const std::string& clientIP) {
         return;
     }
     
-    logger_.info("=== COMPLETED handling client: " + clientIP + " ===");
+    logger_.logf(LogLevel::INFO, LogFormat::COMPLETED_HANDLING, {clientIP});
+}
+
+const char* stageName(SessionStage stage) {
+    switch (stage) {
+        case SessionStage::AUTHENTICATING: return "authenticating";
+        case SessionStage::WAITING: return "waiting";
+        case SessionStage::RECEIVING: return "receiving";
+        case SessionStage::COMPUTING: return "computing";
+        case SessionStage::SENDING: return "sending";
+        case SessionStage::SHARED_MEMORY: return "shm";
+        case SessionStage::TAGGED: return "tagged";
+        case SessionStage::PROXIED: return "proxied";
+        default: return "unknown";
+    }
+}
+
+std::string Server::describeState() {
+    std::ostringstream out;
+    auto now = std::chrono::steady_clock::now();
+    
+    out << "state: " << (draining_ ? "draining" : "serving") << "\n";
+    out << "log_level: " << Logger::levelName(logger_.getLevel()) << "\n";
+    out << "users: " << authenticator_.userCount() << "\n";
+    if (ready_) {
+        out << "workers: " << workers_->size() << " queued_tasks: " << workers_->queued() << "\n";
+    } else {
+        out << "workers: not started (waiting for the first client)\n";
+    }
+    out << "udp: processed=" << udp_.processed() << " rejected=" << udp_.rejected() << "\n";
+    MemoryBudget::Stats memory = memory_.stats();
+    out << "memory: used=" << memory.used << " peak=" << memory.peak
+        << " limit=" << memory.limit << " connection_limit=" << memory.connectionLimit
+        << " waits=" << memory.waits << " rejected=" << memory.rejected << "\n";
+    out << "profiler: " << (profiler_.running() ? "running" : "stopped")
+        << " hz=" << profiler_.hz() << " samples=" << profiler_.samples()
+        << " dropped=" << profiler_.dropped() << "\n";
+    if (IoStats::enabled()) {
+        std::lock_guard<std::mutex> lock(ioMutex_);
+        out << "io: sessions=" << ioSessions_ << " vectors=" << ioVectors_ << "\n";
+        for (size_t i = 0; i < static_cast<size_t>(SessionStage::STAGE_COUNT); ++i) {
+            if (!ioTotals_[i].empty()) {
+                out << "  io stage=" << stageName(static_cast<SessionStage>(i)) << " "
+                    << ioTotals_[i].format() << "\n";
+            }
+        }
+    }
+    
+    // Копируем список под блокировкой, счетчики читаем уже без нее
+    std::vector<std::shared_ptr<SessionInfo>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        for (const auto& entry : sessions_) {
+            sessions.push_back(entry.second);
+        }
+    }
+    out << "sessions: " << sessions.size() << "/" << config_.maxSessions << "\n";
+    for (const auto& session : sessions) {
+        auto age = std::chrono::duration_cast<std::chrono::seconds>(now - session->started);
+        out << "  session id=" << session->id
+            << " client=" << session->clientIP
+            << " stage=" << stageName(session->stage.load(std::memory_order_relaxed))
+            << " vectors=" << session->vectors.load(std::memory_order_relaxed)
+            << " memory=" << session->memory->used();
+        if (IoStats::enabled()) {
+            IoCounters total = {};
+            std::lock_guard<std::mutex> lock(session->ioMutex);
+            for (const IoCounters& stage : session->io) {
+                total.add(stage);
+            }
+            out << " syscalls=" << total.syscalls() << " mallocs=" << total.allocations;
+        }
+        out << " age_s=" << age.count() << "\n";
+    }
+    
+    if (proxy_) {
+        out << proxy_->describe();
+    }
+    
+    auto clients = scheduler_.snapshot();
+    out << "clients: " << clients.size() << "\n";
+    for (const auto& client : clients) {
+        out << "  client key=" << client.key
+            << " weight=" << client.weight
+            << " vectors=" << client.vectors
+            << " elements=" << client.elements
+            << " throttled=" << client.throttled
+            << " rejected=" << client.rejected
+            << " queued=" << client.queued << "\n";
+    }
+    return out.str();
+}
+
+std::string Server::handleAdminCommand(const std::string& command) {
+    std::istringstream input(command);
+    std::string name;
+    std::string argument;
+    input >> name >> argument;
+    
+    if (name == "help") {
+        return "OK\n"
+               "status                  show sessions, workers and client counters\n"
+               "log-level LEVEL         set log level: debug, info, warning, error\n"
+               "reload-users            re-read the client database\n"
+               "drain on|off            stop or resume accepting new clients\n"
+               "workers N               resize the compute worker pool\n"
+               "profile                 print sampled stacks in folded format (flamegraph.pl)\n"
+               "profile start [HZ]      start sampling CPU stacks (default: 99 Hz)\n"
+               "profile stop|reset      stop sampling or discard collected stacks\n"
+               "quit                    close this admin connection\n";
+    }
+    
+    if (name == "status") {
+        return "OK\n" + describeState();
+    }
+    
+    if (name == "log-level") {
+        LogLevel level;
+        if (!Logger::parseLevel(argument, level)) {
+            return "ERR log level must be debug, info, warning or error";
+        }
+        logger_.setLevel(level);
+        return "OK log level " + argument;
+    }
+    
+    if (name == "reload-users") {
+        if (!authenticator_.reloadUsers()) {
+            return "ERR failed to reload users, previous database is kept";
+        }
+        return "OK users " + std::to_string(authenticator_.userCount());
+    }
+    
+    if (name == "drain") {
+        if (argument != "on" && argument != "off") {
+            return "ERR usage: drain on|off";
+        }
+        draining_ = (argument == "on");
+        logger_.info(draining_ ? "Draining: new connections are not accepted"
+                               : "Draining stopped: accepting new connections");
+        return "OK draining " + argument + ", active sessions " + std::to_string(activeSessions());
+    }
+    
+    if (name == "workers") {
+        if (!ready_) {
+            return "ERR worker pool starts with the first client";
+        }
+        try {
+            long count = std::stol(argument);
+            if (count < 1 || count > 1024) {
+                return "ERR worker count must be in range 1-1024";
+            }
+            workers_->resize(static_cast<size_t>(count));
+        } catch (const std::exception&) {
+            return "ERR usage: workers N";
+        }
+        logger_.info("Compute worker threads resized to " + std::to_string(workers_->size()));
+        return "OK workers " + std::to_string(workers_->size());
+    }
+    
+    if (name == "profile") {
+        if (argument.empty()) {
+            return "OK\n" + profiler_.folded();
+        }
+        if (argument == "start") {
+            int hz = config_.profileHz;
+            std::string rate;
+            if (input >> rate) {
+                try {
+                    hz = std::stoi(rate);
+                } catch (const std::exception&) {
+                    return "ERR usage: profile start [HZ]";
+                }
+            }
+            if (profiler_.running()) {
+                return "ERR profiler is already running";
+            }
+            if (!profiler_.start(hz)) {
+                return "ERR profiler rate must be in range 1-1000 Hz";
+            }
+            logger_.info("Profiler started at " + std::to_string(hz) + " Hz");
+            return "OK profiling at " + std::to_string(hz) + " Hz";
+        }
+        if (argument == "stop") {
+            profiler_.stop();
+            logger_.info("Profiler stopped");
+            return "OK samples " + std::to_string(profiler_.samples());
+        }
+        if (argument == "reset") {
+            profiler_.reset();
+            return "OK profile reset";
+        }
+        return "ERR usage: profile [start [HZ]|stop|reset]";
+    }
+    
+    return "ERR unknown command '" + name + "', try help";
 }
 
 int ServerInterface::run(int argc, char* argv[]) {
@@ -353,6 +1606,7 @@ int ServerInterface::run(int argc, char* argv[]) {
         
         ServerConfig serverConfig = config_.getConfig();
         Server server(serverConfig);
+        server.setExecArguments(std::vector<std::string>(argv, argv + argc));
         server.run();
         
     } catch (const ConfigException& e) {
@@ -5,13 +5,59 @@
 #include "logger.h"
 #include "authenticator.h"
 #include "network.h"
+#include "protocol.h"
+#include "shm_ring.h"
+#include "udp_endpoint.h"
+#include "worker_pool.h"
+#include "client_scheduler.h"
+#include "admin_socket.h"
+#include "proxy.h"
+#include "capture.h"
+#include "memory_budget.h"
+#include "profiler.h"
+#include "io_stats.h"
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <memory>
 #include <csignal>
 #include <vector>
 #include <cmath>
 #include <limits>
 #include <chrono>
+#include <string>
+#include <map>
+
+// Что сейчас делает сессия; видно в ответе на команду status
+enum class SessionStage {
+    AUTHENTICATING,
+    WAITING,
+    RECEIVING,
+    COMPUTING,
+    SENDING,
+    SHARED_MEMORY,
+    TAGGED,
+    PROXIED,
+    STAGE_COUNT
+};
+
+const char* stageName(SessionStage stage);
+
+struct SessionInfo {
+    uint64_t id;
+    std::string clientIP;
+    std::chrono::steady_clock::time_point started;
+    std::atomic<SessionStage> stage{SessionStage::AUTHENTICATING};
+    std::atomic<uint64_t> vectors{0};
+    std::unique_ptr<MemoryBudget::Account> memory;  // Данные клиента, которые держит сессия
+    bool quickAck = false;  // TCP-клиент при --tcp-quickack
+    
+    // --io-stats: вызовы и выделения памяти по этапам. Поток сессии
+    // пополняет их при смене этапа, задачи пула - по окончании своей части.
+    std::mutex ioMutex;
+    IoCounters io[static_cast<size_t>(SessionStage::STAGE_COUNT)] = {};
+    IoCounters ioMark = {};  // Счетчики потока сессии на начало текущего этапа
+};
 
 class Server {
 private:
@@ -19,8 +65,43 @@ private:
     Logger logger_;
     Authenticator authenticator_;
     NetworkManager network_;
+    ClientScheduler scheduler_;
+    MemoryBudget memory_;
+    UdpEndpoint udp_;
+    std::unique_ptr<WorkerPool> workers_;
+    std::unique_ptr<Proxy> proxy_;  // Режим --proxy: клиенты передаются бэкендам
+    std::unique_ptr<TrafficCapture> capture_;  // Режим --capture
+    SamplingProfiler profiler_;  // --profile или команда profile start
+    
+    // --io-stats: итоги завершенных сессий по этапам
+    std::mutex ioMutex_;
+    IoCounters ioTotals_[static_cast<size_t>(SessionStage::STAGE_COUNT)];
+    uint64_t ioSessions_;
+    uint64_t ioVectors_;
     std::atomic<bool> running_;
+    std::mutex activityMutex_;
     std::chrono::steady_clock::time_point lastActivity_;
+    std::chrono::steady_clock::time_point lastStatsReport_;
+    
+    // Параллельные сессии (при maxSessions > 1)
+    std::mutex sessionsMutex_;
+    std::condition_variable sessionsChanged_;
+    size_t activeSessions_;
+    std::map<uint64_t, std::shared_ptr<SessionInfo>> sessions_;
+    uint64_t nextSessionId_;
+    std::vector<std::string> execArguments_;
+    
+    // Режим вывода из балансировки: новые подключения не принимаются
+    std::atomic<bool> draining_;
+    
+    // База пользователей загружена и пул потоков запущен (см. --lazy-init)
+    std::atomic<bool> ready_;
+    
+    // Процесс запущен главным процессом в режиме --processes
+    bool preforkWorker_;
+    
+    // Объявлен последним: поток команд останавливается раньше остальных членов
+    AdminSocket admin_;
     
 public:
     Server(const ServerConfig& config);
@@ -28,10 +109,44 @@ public:
     
     bool initialize();
     void run();
+    
+    // Работа без сети: только база пользователей и пул потоков. Сессии
+    // передаются через serveLocal() по любому транспорту (например,
+    // SocketPairTransport в бенчмарке); соединение закрывается по окончании.
+    bool initializeLocal();
+    void serveLocal(Transport& transport, int connection, const std::string& peer);
+    // Итоги --io-stats завершенных сессий (по индексу SessionStage) и число их векторов
+    std::vector<IoCounters> ioTotals(uint64_t& vectors);
     void stop();
+    void setExecArguments(const std::vector<std::string>& arguments);
     
 private:
-    void handleClient(int clientSocket, const std::string& clientIP);
+    void startWorkerPool();
+    bool completeInitialization();
+    bool startProxy();
+    bool startCapture();
+    bool runMaster();
+    void serveConnection(int listenSocket);
+    void runSession(Transport& transport, int clientSocket, const std::string& clientIP);
+    void pinSessionThread(int clientSocket);
+    void waitForSessions();
+    size_t activeSessions();
+    void reportClientStats();
+    void writeProfile();
+    void handleClient(Transport& transport, int clientSocket, const std::string& clientIP, SessionInfo& session);
+    void enterStage(SessionInfo& session, SessionStage stage);
+    void expectRequest(int clientSocket, SessionInfo& session);
+    void chargeIo(SessionInfo& session, SessionStage stage, IoCounters& mark);
+    void finishSessionIo(SessionInfo& session);
+    std::string handleAdminCommand(const std::string& command);
+    std::string describeState();
+    void handleSharedMemorySession(int clientSocket, const std::string& clientIP, const std::string& clientKey,
+                                   SessionInfo& session);
+    void handleTaggedSession(Transport& transport, int clientSocket, const std::string& clientIP,
+                             const std::string& clientKey, SessionInfo& info);
+    void handleFramedSession(Transport& transport, int clientSocket, const std::string& clientIP,
+                             const std::string& clientKey, SessionInfo& session);
+    bool performUpgrade();
     void updateActivity();
     bool shouldShutdownDueToInactivity();
 };
@@ -0,0 +1,105 @@
+#include "shared_user_table.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+
+SharedUserTable::SharedUserTable() : memory_(nullptr), size_(0) {
+}
+
+SharedUserTable::~SharedUserTable() {
+    if (memory_) {
+        munmap(memory_, size_);
+    }
+}
+
+bool SharedUserTable::build(const std::unordered_map<std::string, std::string>& users) {
+    if (memory_) {
+        return false;
+    }
+
+    std::vector<std::pair<std::string, std::string>> sorted(users.begin(), users.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t dataSize = 0;
+    for (const auto& user : sorted) {
+        dataSize += user.first.size() + user.second.size();
+    }
+    size_t dataOffset = sizeof(Header) + sorted.size() * sizeof(Entry);
+    size_t total = dataOffset + dataSize;
+    if (total > UINT32_MAX) {
+        return false;
+    }
+
+    void* memory = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+
+    char* base = static_cast<char*>(memory);
+    Header* header = reinterpret_cast<Header*>(base);
+    Entry* entry = reinterpret_cast<Entry*>(base + sizeof(Header));
+    header->count = static_cast<uint32_t>(sorted.size());
+    header->dataOffset = static_cast<uint32_t>(dataOffset);
+
+    uint32_t offset = 0;
+    for (const auto& user : sorted) {
+        entry->loginOffset = offset;
+        entry->loginLength = static_cast<uint32_t>(user.first.size());
+        memcpy(base + dataOffset + offset, user.first.data(), user.first.size());
+        offset += entry->loginLength;
+
+        entry->passwordOffset = offset;
+        entry->passwordLength = static_cast<uint32_t>(user.second.size());
+        memcpy(base + dataOffset + offset, user.second.data(), user.second.size());
+        offset += entry->passwordLength;
+        ++entry;
+    }
+
+    // Дальше таблица только читается - ошибка записи станет SIGSEGV, а не порчей данных
+    if (mprotect(memory, total, PROT_READ) != 0) {
+        munmap(memory, total);
+        return false;
+    }
+
+    memory_ = memory;
+    size_ = total;
+    return true;
+}
+
+const SharedUserTable::Entry* SharedUserTable::entries() const {
+    return reinterpret_cast<const Entry*>(static_cast<const char*>(memory_) + sizeof(Header));
+}
+
+const char* SharedUserTable::data() const {
+    return static_cast<const char*>(memory_) + header()->dataOffset;
+}
+
+size_t SharedUserTable::size() const {
+    return memory_ ? header()->count : 0;
+}
+
+bool SharedUserTable::find(const std::string& login, std::string& password) const {
+    if (!memory_) {
+        return false;
+    }
+
+    const Entry* first = entries();
+    const Entry* last = first + header()->count;
+    const char* strings = data();
+
+    auto compare = [strings](const Entry& entry, const std::string& key) {
+        size_t common = std::min<size_t>(entry.loginLength, key.size());
+        int result = memcmp(strings + entry.loginOffset, key.data(), common);
+        return result < 0 || (result == 0 && entry.loginLength < key.size());
+    };
+
+    const Entry* found = std::lower_bound(first, last, login, compare);
+    if (found == last || found->loginLength != login.size() ||
+        memcmp(strings + found->loginOffset, login.data(), login.size()) != 0) {
+        return false;
+    }
+
+    password.assign(strings + found->passwordOffset, found->passwordLength);
+    return true;
+}
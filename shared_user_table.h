@@ -0,0 +1,49 @@
+#ifndef SHARED_USER_TABLE_H
+#define SHARED_USER_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Таблица пользователей в анонимной общей памяти, защищенной от записи.
+// Строится один раз в главном процессе до fork(): рабочие процессы читают
+// одни и те же страницы, а не держат каждый свою копию таблицы.
+//
+// Формат: заголовок, отсортированный по логину массив записей и блок строк.
+class SharedUserTable {
+private:
+    struct Header {
+        uint32_t count;
+        uint32_t dataOffset;
+    };
+
+    struct Entry {
+        uint32_t loginOffset;
+        uint32_t loginLength;
+        uint32_t passwordOffset;
+        uint32_t passwordLength;
+    };
+
+    void* memory_;
+    size_t size_;
+
+public:
+    SharedUserTable();
+    ~SharedUserTable();
+
+    SharedUserTable(const SharedUserTable&) = delete;
+    SharedUserTable& operator=(const SharedUserTable&) = delete;
+
+    bool build(const std::unordered_map<std::string, std::string>& users);
+    bool find(const std::string& login, std::string& password) const;
+    size_t size() const;
+    size_t bytes() const { return size_; }
+
+private:
+    const Header* header() const { return static_cast<const Header*>(memory_); }
+    const Entry* entries() const;
+    const char* data() const;
+};
+
+#endif // SHARED_USER_TABLE_H
@@ -0,0 +1,366 @@
+#include "shm_ring.h"
+#include "io_stats.h"
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+// Маркер "пропустить остаток буфера и продолжить с начала"
+static const uint32_t WRAP_MARKER = 0xFFFFFFFFu;
+
+// Размер memfd нельзя менять: усеченный другой стороной файл дал бы
+// SIGBUS при следующем обращении к отображению
+static const int SHM_REQUIRED_SEALS = F_SEAL_SHRINK | F_SEAL_GROW;
+
+ShmRing::ShmRing()
+    : header_(nullptr), data_(nullptr), capacity_(0), readerEvent_(-1), writerEvent_(-1),
+      head_(0), tail_(0), pendingHead_(0), frontSize_(0), corrupted_(true) {}
+
+ShmRing::ShmRing(void* region, uint64_t capacity, int readerEvent, int writerEvent)
+    : header_(static_cast<ShmRingHeader*>(region)),
+      data_(static_cast<char*>(region) + HEADER_SIZE),
+      capacity_(capacity),
+      readerEvent_(readerEvent),
+      writerEvent_(writerEvent),
+      head_(header_->head.load(std::memory_order_acquire)),
+      tail_(header_->tail.load(std::memory_order_acquire)),
+      pendingHead_(0),
+      frontSize_(0),
+      corrupted_(capacity == 0 || capacity % 8 != 0 || head_ - tail_ > capacity ||
+                 head_ % 8 != 0 || tail_ % 8 != 0) {}
+
+size_t ShmRing::regionSize(uint64_t capacity) {
+    return HEADER_SIZE + capacity;
+}
+
+void ShmRing::format(void* region, uint64_t capacity) {
+    static_assert(sizeof(ShmRingHeader) <= HEADER_SIZE, "ShmRingHeader does not fit");
+    ShmRingHeader* header = new (region) ShmRingHeader();
+    header->head.store(0);
+    header->tail.store(0);
+    header->readerWaiting.store(0);
+    header->writerWaiting.store(0);
+    header->capacity = capacity;
+}
+
+size_t ShmRing::recordSize(uint32_t payloadSize) {
+    return RECORD_HEADER_SIZE + ((static_cast<size_t>(payloadSize) + 7) & ~static_cast<size_t>(7));
+}
+
+// Индекс другой стороны годится, только если он не дальше емкости от нашего
+bool ShmRing::peerTail(uint64_t& tail) {
+    tail = header_->tail.load(std::memory_order_acquire);
+    if (corrupted_ || head_ - tail > capacity_) {
+        corrupted_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool ShmRing::peerHead(uint64_t& head) {
+    head = header_->head.load(std::memory_order_acquire);
+    if (corrupted_ || head - tail_ > capacity_) {
+        corrupted_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool ShmRing::hasSpace(uint32_t payloadSize) {
+    uint64_t tail;
+    if (!peerTail(tail)) {
+        return false;
+    }
+    uint64_t offset = head_ % capacity_;
+    size_t needed = recordSize(payloadSize);
+
+    // Запись не помещается до конца буфера - понадобится маркер переноса
+    if (offset + needed > capacity_) {
+        needed += capacity_ - offset;
+    }
+    return capacity_ - (head_ - tail) >= needed;
+}
+
+void* ShmRing::reserve(uint32_t payloadSize) {
+    if (recordSize(payloadSize) > capacity_) {
+        return nullptr;
+    }
+    if (!hasSpace(payloadSize)) {
+        return nullptr;
+    }
+
+    uint64_t head = head_;
+    uint64_t offset = head % capacity_;
+
+    if (offset + recordSize(payloadSize) > capacity_) {
+        // Остаток буфера пропускается, запись начинается с нуля
+        memcpy(data_ + offset, &WRAP_MARKER, sizeof(WRAP_MARKER));
+        head += capacity_ - offset;
+        offset = 0;
+    }
+
+    pendingHead_ = head;
+    return data_ + offset + RECORD_HEADER_SIZE;
+}
+
+void ShmRing::publish(uint32_t payloadSize, uint32_t tag) {
+    uint64_t offset = pendingHead_ % capacity_;
+    memcpy(data_ + offset, &payloadSize, sizeof(payloadSize));
+    memcpy(data_ + offset + sizeof(payloadSize), &tag, sizeof(tag));
+
+    head_ = pendingHead_ + recordSize(payloadSize);
+    header_->head.store(head_, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->readerWaiting.load(std::memory_order_relaxed)) {
+        notify(readerEvent_);
+    }
+}
+
+bool ShmRing::hasRecord() {
+    uint64_t head;
+    return peerHead(head) && head != tail_;
+}
+
+const void* ShmRing::front(uint32_t& payloadSize, uint32_t& tag) {
+    uint64_t head;
+    while (peerHead(head) && head != tail_) {
+        // Смещения кратны 8, а емкость - тоже, поэтому заголовок записи
+        // всегда помещается до конца буфера
+        uint64_t offset = tail_ % capacity_;
+        uint64_t available = head - tail_;
+
+        uint32_t size;
+        memcpy(&size, data_ + offset, sizeof(size));
+        if (size == WRAP_MARKER) {
+            if (capacity_ - offset > available) {
+                corrupted_ = true;
+                return nullptr;
+            }
+            tail_ += capacity_ - offset;
+            header_->tail.store(tail_, std::memory_order_release);
+            continue;
+        }
+
+        // Запись должна быть опубликована целиком и не выходить за буфер
+        size_t length = recordSize(size);
+        if (length > available || offset + length > capacity_) {
+            corrupted_ = true;
+            return nullptr;
+        }
+
+        frontSize_ = size;
+        payloadSize = size;
+        memcpy(&tag, data_ + offset + sizeof(size), sizeof(tag));
+        return data_ + offset + RECORD_HEADER_SIZE;
+    }
+    return nullptr;
+}
+
+void ShmRing::pop() {
+    tail_ += recordSize(frontSize_);
+    header_->tail.store(tail_, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->writerWaiting.load(std::memory_order_relaxed)) {
+        notify(writerEvent_);
+    }
+}
+
+bool ShmRing::waitReadable(int extraSocket, int timeoutMs) {
+    while (true) {
+        header_->readerWaiting.store(1, std::memory_order_seq_cst);
+        if (hasRecord()) {
+            header_->readerWaiting.store(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        if (corrupted_) {
+            return false;
+        }
+
+        bool woken = waitEvent(readerEvent_, extraSocket, timeoutMs);
+        header_->readerWaiting.store(0, std::memory_order_relaxed);
+        if (!woken) {
+            return hasRecord();
+        }
+        if (hasRecord()) {
+            return true;
+        }
+    }
+}
+
+bool ShmRing::waitWritable(uint32_t payloadSize, int extraSocket, int timeoutMs) {
+    if (recordSize(payloadSize) > capacity_) {
+        return false;
+    }
+
+    while (true) {
+        header_->writerWaiting.store(1, std::memory_order_seq_cst);
+        if (hasSpace(payloadSize)) {
+            header_->writerWaiting.store(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        if (corrupted_) {
+            return false;
+        }
+
+        bool woken = waitEvent(writerEvent_, extraSocket, timeoutMs);
+        header_->writerWaiting.store(0, std::memory_order_relaxed);
+        if (!woken) {
+            return hasSpace(payloadSize);
+        }
+        if (hasSpace(payloadSize)) {
+            return true;
+        }
+    }
+}
+
+bool ShmRing::waitEvent(int eventFd, int extraSocket, int timeoutMs) {
+    struct pollfd fds[2];
+    fds[0].fd = eventFd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = extraSocket;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    nfds_t count = extraSocket != -1 ? 2 : 1;
+
+    int result;
+    do {
+        result = poll(fds, count, timeoutMs);
+        IoStats::call(IoCall::POLL, 0);
+    } while (result < 0 && errno == EINTR);
+
+    if (result <= 0) {
+        return false;
+    }
+
+    if (fds[0].revents & POLLIN) {
+        uint64_t value;
+        ssize_t received = read(eventFd, &value, sizeof(value));
+        IoStats::call(IoCall::RECV, received);
+        return true;
+    }
+
+    // Активность на сокете управления означает закрытие соединения
+    return false;
+}
+
+void ShmRing::notify(int eventFd) {
+    uint64_t one = 1;
+    ssize_t written = write(eventFd, &one, sizeof(one));
+    IoStats::call(IoCall::WRITE, written);
+}
+
+ShmChannel::ShmChannel()
+    : region_(nullptr), regionSize_(0), memFd_(-1), serverEvent_(-1), clientEvent_(-1), ringCapacity_(0) {}
+
+ShmChannel::~ShmChannel() {
+    release();
+}
+
+bool ShmChannel::create(uint64_t ringCapacity) {
+    release();
+
+    ringCapacity = (ringCapacity + 7) & ~static_cast<uint64_t>(7);
+    regionSize_ = 2 * ShmRing::regionSize(ringCapacity);
+
+    memFd_ = memfd_create("vcalc-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memFd_ == -1 || ftruncate(memFd_, static_cast<off_t>(regionSize_)) < 0 ||
+        fcntl(memFd_, F_ADD_SEALS, SHM_REQUIRED_SEALS | F_SEAL_SEAL) < 0) {
+        release();
+        return false;
+    }
+
+    region_ = mmap(nullptr, regionSize_, PROT_READ | PROT_WRITE, MAP_SHARED, memFd_, 0);
+    if (region_ == MAP_FAILED) {
+        region_ = nullptr;
+        release();
+        return false;
+    }
+
+    serverEvent_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    clientEvent_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (serverEvent_ == -1 || clientEvent_ == -1) {
+        release();
+        return false;
+    }
+
+    ShmRing::format(region_, ringCapacity);
+    ShmRing::format(static_cast<char*>(region_) + ShmRing::regionSize(ringCapacity), ringCapacity);
+    ringCapacity_ = ringCapacity;
+    return true;
+}
+
+bool ShmChannel::attach(int memFd, int serverEvent, int clientEvent) {
+    release();
+
+    memFd_ = memFd;
+    serverEvent_ = serverEvent;
+    clientEvent_ = clientEvent;
+
+    int seals = fcntl(memFd_, F_GET_SEALS);
+    if (seals < 0 || (seals & SHM_REQUIRED_SEALS) != SHM_REQUIRED_SEALS) {
+        release();
+        return false;
+    }
+
+    off_t size = lseek(memFd_, 0, SEEK_END);
+    if (size <= static_cast<off_t>(2 * ShmRing::HEADER_SIZE)) {
+        release();
+        return false;
+    }
+
+    regionSize_ = static_cast<size_t>(size);
+    region_ = mmap(nullptr, regionSize_, PROT_READ | PROT_WRITE, MAP_SHARED, memFd_, 0);
+    if (region_ == MAP_FAILED) {
+        region_ = nullptr;
+        release();
+        return false;
+    }
+
+    // Емкость читается из памяти один раз и дальше хранится у себя
+    ringCapacity_ = static_cast<const ShmRingHeader*>(region_)->capacity;
+    if (ringCapacity_ == 0 || ringCapacity_ % 8 != 0 ||
+        ShmRing::regionSize(ringCapacity_) * 2 != regionSize_) {
+        release();
+        return false;
+    }
+    return true;
+}
+
+void ShmChannel::release() {
+    if (region_ != nullptr) {
+        munmap(region_, regionSize_);
+        region_ = nullptr;
+    }
+    if (memFd_ != -1) {
+        close(memFd_);
+        memFd_ = -1;
+    }
+    if (serverEvent_ != -1) {
+        close(serverEvent_);
+        serverEvent_ = -1;
+    }
+    if (clientEvent_ != -1) {
+        close(clientEvent_);
+        clientEvent_ = -1;
+    }
+    regionSize_ = 0;
+    ringCapacity_ = 0;
+}
+
+ShmRing ShmChannel::requestRing() const {
+    return ShmRing(region_, ringCapacity_, serverEvent_, clientEvent_);
+}
+
+ShmRing ShmChannel::responseRing() const {
+    return ShmRing(static_cast<char*>(region_) + ShmRing::regionSize(ringCapacity_), ringCapacity_,
+                   clientEvent_, serverEvent_);
+}
@@ -0,0 +1,116 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Заголовок кольцевого буфера в разделяемой памяти.
+// head двигает только производитель, tail - только потребитель.
+struct ShmRingHeader {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint32_t> readerWaiting;
+    std::atomic<uint32_t> writerWaiting;
+    uint64_t capacity;
+};
+
+// Кольцо с одним производителем и одним потребителем (SPSC).
+// Записи: [uint32 размер данных][uint32 метка][данные, выровненные до 8 байт].
+// Запись никогда не разрывается концом буфера, поэтому данные можно
+// читать и писать прямо в разделяемой памяти без копирования.
+// Сторона, у которой нет работы, спит на своем eventfd; будят ее только
+// если она выставила флаг ожидания, поэтому в потоке данных системных
+// вызовов почти нет.
+// Другая сторона может писать в общую память что угодно, поэтому емкость
+// и собственный индекс (head производителя, tail потребителя) хранятся
+// в объекте, а в память только публикуются. Индекс и записи другой стороны
+// проверяются; после первого нарушения кольцо считается испорченным.
+class ShmRing {
+private:
+    ShmRingHeader* header_;
+    char* data_;
+    uint64_t capacity_;
+    int readerEvent_;
+    int writerEvent_;
+    uint64_t head_;
+    uint64_t tail_;
+    uint64_t pendingHead_;
+    uint32_t frontSize_;  // Размер записи, проверенной в front(), для pop()
+    bool corrupted_;
+
+public:
+    static const size_t HEADER_SIZE = 256;
+    static const size_t RECORD_HEADER_SIZE = 8;
+
+    ShmRing();
+    // Индексы берутся из памяти один раз: кольцо создается до того,
+    // как память увидит другая сторона, или уже своей стороной
+    ShmRing(void* region, uint64_t capacity, int readerEvent, int writerEvent);
+
+    static size_t regionSize(uint64_t capacity);
+    static void format(void* region, uint64_t capacity);
+    static size_t recordSize(uint32_t payloadSize);
+
+    uint64_t capacity() const { return capacity_; }
+    // Другая сторона нарушила формат кольца; сессию нужно закончить
+    bool corrupted() const { return corrupted_; }
+
+    // Производитель: reserve() возвращает место под данные или nullptr,
+    // если кольцо заполнено; publish() делает запись видимой потребителю.
+    void* reserve(uint32_t payloadSize);
+    void publish(uint32_t payloadSize, uint32_t tag);
+
+    // Потребитель: front() возвращает данные следующей записи или nullptr.
+    const void* front(uint32_t& payloadSize, uint32_t& tag);
+    void pop();
+
+    // Ожидание данных/места. extraSocket (если не -1) прерывает ожидание
+    // при закрытии соединения. Возвращает false по таймауту, обрыву
+    // или порче кольца.
+    bool waitReadable(int extraSocket, int timeoutMs);
+    bool waitWritable(uint32_t payloadSize, int extraSocket, int timeoutMs);
+
+private:
+    bool peerHead(uint64_t& head);
+    bool peerTail(uint64_t& tail);
+    bool hasRecord();
+    bool hasSpace(uint32_t payloadSize);
+    static bool waitEvent(int eventFd, int extraSocket, int timeoutMs);
+    static void notify(int eventFd);
+};
+
+// Общая область памяти сессии: кольцо запросов (клиент -> сервер)
+// и кольцо ответов (сервер -> клиент) в одном memfd.
+// create() запечатывает размер memfd до передачи дескриптора,
+// attach() не отображает memfd без этих печатей.
+class ShmChannel {
+private:
+    void* region_;
+    size_t regionSize_;
+    int memFd_;
+    int serverEvent_;
+    int clientEvent_;
+    uint64_t ringCapacity_;
+
+public:
+    ShmChannel();
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel&) = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    bool create(uint64_t ringCapacity);
+    bool attach(int memFd, int serverEvent, int clientEvent);
+    void release();
+
+    ShmRing requestRing() const;
+    ShmRing responseRing() const;
+
+    int memFd() const { return memFd_; }
+    int serverEvent() const { return serverEvent_; }
+    int clientEvent() const { return clientEvent_; }
+    uint64_t ringCapacity() const { return ringCapacity_; }
+};
+
+#endif // SHM_RING_H
@@ -0,0 +1,70 @@
+#include "transport.h"
+#include "io_stats.h"
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool Transport::receiveLogin(int connection, std::string& login) {
+    char buffer[256];
+    ssize_t bytesReceived = receiveSome(connection, buffer, sizeof(buffer) - 1);
+    if (bytesReceived <= 0) {
+        return false;
+    }
+    login.assign(buffer, bytesReceived);
+    return true;
+}
+
+bool SocketPairTransport::open(int& serverEnd, int& clientEnd) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        return false;
+    }
+    serverEnd = fds[0];
+    clientEnd = fds[1];
+    return true;
+}
+
+ssize_t SocketPairTransport::receiveSome(int connection, void* buffer, size_t size) {
+    ssize_t bytesReceived;
+    do {
+        bytesReceived = recv(connection, buffer, size, 0);
+        IoStats::call(IoCall::RECV, bytesReceived);
+    } while (bytesReceived < 0 && errno == EINTR);
+    return bytesReceived;
+}
+
+bool SocketPairTransport::receiveData(int connection, void* buffer, size_t size) {
+    char* data = static_cast<char*>(buffer);
+    size_t totalReceived = 0;
+    while (totalReceived < size) {
+        ssize_t bytesReceived = receiveSome(connection, data + totalReceived, size - totalReceived);
+        if (bytesReceived <= 0) {
+            return false;
+        }
+        totalReceived += bytesReceived;
+    }
+    return true;
+}
+
+bool SocketPairTransport::sendData(int connection, const void* data, size_t size) {
+    const char* byteData = static_cast<const char*>(data);
+    size_t totalSent = 0;
+    while (totalSent < size) {
+        ssize_t bytesSent = send(connection, byteData + totalSent, size - totalSent, MSG_NOSIGNAL);
+        IoStats::call(IoCall::SEND, bytesSent);
+        if (bytesSent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesSent <= 0) {
+            return false;
+        }
+        totalSent += bytesSent;
+    }
+    return true;
+}
+
+void SocketPairTransport::closeClient(int connection) {
+    if (connection != -1) {
+        close(connection);
+    }
+}
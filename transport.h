@@ -0,0 +1,44 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+// Передача байтов протокола по уже установленному соединению.
+// Аутентификация и обработка сессии работают через этот интерфейс,
+// поэтому полный путь протокола можно прогнать без сети (SocketPairTransport).
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    // Логин приходит одним сообщением без длины: читается то, что уже пришло
+    virtual bool receiveLogin(int connection, std::string& login);
+    // Хеш пароля читается как receiveSome; отдельный метод позволяет не
+    // записывать его вместе с остальным трафиком (см. CaptureTransport)
+    virtual ssize_t receiveCredential(int connection, void* buffer, size_t size) {
+        return receiveSome(connection, buffer, size);
+    }
+
+    // Читает то, что уже пришло, но не больше size байт; 0 - соединение закрыто
+    virtual ssize_t receiveSome(int connection, void* buffer, size_t size) = 0;
+    // Читает ровно size байт
+    virtual bool receiveData(int connection, void* buffer, size_t size) = 0;
+    virtual bool sendData(int connection, const void* data, size_t size) = 0;
+    virtual void closeClient(int connection) = 0;
+};
+
+// Соединения внутри процесса на паре сокетов socketpair(). Ничего не пишет
+// в лог, чтобы измерения не зависели от его настроек.
+class SocketPairTransport : public Transport {
+public:
+    // serverEnd передается серверу, clientEnd - клиенту
+    bool open(int& serverEnd, int& clientEnd);
+
+    ssize_t receiveSome(int connection, void* buffer, size_t size) override;
+    bool receiveData(int connection, void* buffer, size_t size) override;
+    bool sendData(int connection, const void* data, size_t size) override;
+    void closeClient(int connection) override;
+};
+
+#endif // TRANSPORT_H
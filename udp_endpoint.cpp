@@ -0,0 +1,186 @@
+#include "udp_endpoint.h"
+#include "protocol.h"
+#include "vector_math.h"
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <endian.h>
+
+// Сколько пачек обработать за один вызов, чтобы не задерживать TCP-клиентов
+static const size_t MAX_BATCHES_PER_CALL = 16;
+
+UdpEndpoint::UdpEndpoint(Logger& logger, Authenticator& authenticator,
+                         ClientScheduler& scheduler, bool keyByLogin)
+    : logger_(logger),
+      authenticator_(authenticator),
+      scheduler_(scheduler),
+      keyByLogin_(keyByLogin),
+      processed_(0),
+      rejected_(0) {}
+
+void UdpEndpoint::allocateBuffers() {
+    // Буферы выделяются в потоке цикла приема при первой датаграмме,
+    // то есть уже после его привязки к процессору - на его NUMA-узле
+    receiveBuffers_.resize(BATCH_SIZE * UDP_MAX_DATAGRAM);
+    sendBuffers_.resize(BATCH_SIZE * UDP_RESPONSE_SIZE);
+    addresses_.resize(BATCH_SIZE);
+    receiveIov_.resize(BATCH_SIZE);
+    sendIov_.resize(BATCH_SIZE);
+    receiveMessages_.resize(BATCH_SIZE);
+    sendMessages_.resize(BATCH_SIZE);
+    elements_.resize(MAX_VECTOR_SIZE);
+
+    for (size_t i = 0; i < BATCH_SIZE; ++i) {
+        receiveIov_[i].iov_base = &receiveBuffers_[i * UDP_MAX_DATAGRAM];
+        receiveIov_[i].iov_len = UDP_MAX_DATAGRAM;
+        sendIov_[i].iov_base = &sendBuffers_[i * UDP_RESPONSE_SIZE];
+        sendIov_[i].iov_len = UDP_RESPONSE_SIZE;
+    }
+}
+
+size_t UdpEndpoint::processPending(int udpSocket) {
+    if (receiveBuffers_.empty()) {
+        allocateBuffers();
+    }
+
+    size_t total = 0;
+
+    for (size_t round = 0; round < MAX_BATCHES_PER_CALL; ++round) {
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            memset(&receiveMessages_[i], 0, sizeof(receiveMessages_[i]));
+            receiveMessages_[i].msg_hdr.msg_iov = &receiveIov_[i];
+            receiveMessages_[i].msg_hdr.msg_iovlen = 1;
+            receiveMessages_[i].msg_hdr.msg_name = &addresses_[i];
+            receiveMessages_[i].msg_hdr.msg_namelen = sizeof(addresses_[i]);
+        }
+
+        int received = recvmmsg(udpSocket, receiveMessages_.data(), BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (received <= 0) {
+            if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                logger_.error("Failed to receive UDP datagrams: " + std::string(strerror(errno)));
+            }
+            break;
+        }
+
+        uint64_t now = static_cast<uint64_t>(time(nullptr));
+        size_t rejectedInBatch = 0;
+
+        for (int i = 0; i < received; ++i) {
+            uint32_t requestId = 0;
+            float product = 0.0f;
+            uint32_t status = handleDatagram(&receiveBuffers_[i * UDP_MAX_DATAGRAM],
+                                             receiveMessages_[i].msg_len, addresses_[i],
+                                             now, requestId, product);
+            if (status != UDP_STATUS_OK) {
+                rejectedInBatch++;
+            }
+
+            uint32_t bits;
+            memcpy(&bits, &product, sizeof(bits));
+            uint32_t response[3] = {htole32(requestId), htole32(status), htole32(bits)};
+            memcpy(&sendBuffers_[i * UDP_RESPONSE_SIZE], response, sizeof(response));
+
+            memset(&sendMessages_[i], 0, sizeof(sendMessages_[i]));
+            sendMessages_[i].msg_hdr.msg_iov = &sendIov_[i];
+            sendMessages_[i].msg_hdr.msg_iovlen = 1;
+            sendMessages_[i].msg_hdr.msg_name = &addresses_[i];
+            sendMessages_[i].msg_hdr.msg_namelen = receiveMessages_[i].msg_hdr.msg_namelen;
+        }
+
+        int sent = 0;
+        while (sent < received) {
+            int result = sendmmsg(udpSocket, &sendMessages_[sent], received - sent, 0);
+            if (result <= 0) {
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                logger_.error("Failed to send UDP responses: " + std::string(strerror(errno)));
+                break;
+            }
+            sent += result;
+        }
+
+        processed_ += received - rejectedInBatch;
+        rejected_ += rejectedInBatch;
+        total += received;
+
+        logger_.debug("UDP batch: " + std::to_string(received) + " datagrams, " +
+                      std::to_string(rejectedInBatch) + " rejected");
+
+        if (static_cast<size_t>(received) < BATCH_SIZE) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+uint32_t UdpEndpoint::handleDatagram(const char* data, size_t size, const struct sockaddr_in& source,
+                                     uint64_t now, uint32_t& requestId, float& product) {
+    size_t offset = 0;
+    if (size < 1) {
+        return UDP_STATUS_BAD_REQUEST;
+    }
+
+    size_t loginLength = static_cast<unsigned char>(data[0]);
+    offset = 1;
+    if (size < offset + loginLength + 8 + UDP_TOKEN_LENGTH + 8) {
+        return UDP_STATUS_BAD_REQUEST;
+    }
+
+    std::string login(data + offset, loginLength);
+    offset += loginLength;
+
+    uint64_t timestamp;
+    memcpy(&timestamp, data + offset, sizeof(timestamp));
+    timestamp = le64toh(timestamp);
+    offset += sizeof(timestamp);
+
+    std::string token(data + offset, UDP_TOKEN_LENGTH);
+    offset += UDP_TOKEN_LENGTH;
+
+    // Токен подписывает все, что идет после него
+    const char* body = data + offset;
+    size_t bodySize = size - offset;
+
+    memcpy(&requestId, data + offset, sizeof(requestId));
+    requestId = le32toh(requestId);
+    offset += sizeof(requestId);
+
+    if (!authenticator_.verifyToken(login, timestamp, requestId, token, body, bodySize, now, UDP_MAX_CLOCK_SKEW)) {
+        return UDP_STATUS_AUTH_FAILED;
+    }
+
+    uint32_t vectorSize;
+    memcpy(&vectorSize, data + offset, sizeof(vectorSize));
+    vectorSize = le32toh(vectorSize);
+    offset += sizeof(vectorSize);
+
+    if (vectorSize == 0 || vectorSize > MAX_VECTOR_SIZE ||
+        size != offset + static_cast<size_t>(vectorSize) * sizeof(float)) {
+        return UDP_STATUS_BAD_REQUEST;
+    }
+
+    // Датаграммы не ждут токенов: сверх лимита запрос сразу отклоняется
+    std::string clientKey;
+    if (keyByLogin_) {
+        clientKey = login;
+    } else {
+        char ipBuffer[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &source.sin_addr, ipBuffer, INET_ADDRSTRLEN);
+        clientKey = ipBuffer;
+    }
+    if (!scheduler_.tryAdmit(clientKey, vectorSize)) {
+        return UDP_STATUS_RATE_LIMITED;
+    }
+
+    for (uint32_t i = 0; i < vectorSize; ++i) {
+        uint32_t bits;
+        memcpy(&bits, data + offset + i * sizeof(float), sizeof(bits));
+        bits = le32toh(bits);
+        memcpy(&elements_[i], &bits, sizeof(bits));
+    }
+
+    product = calculateProductWithOverflowCheck(elements_.data(), vectorSize, logger_);
+    return UDP_STATUS_OK;
+}
@@ -0,0 +1,52 @@
+#ifndef UDP_ENDPOINT_H
+#define UDP_ENDPOINT_H
+
+#include <cstdint>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "logger.h"
+#include "authenticator.h"
+#include "client_scheduler.h"
+
+// Обработка UDP-запросов (один вектор - одна датаграмма).
+// Датаграммы читаются и отправляются пачками через recvmmsg/sendmmsg,
+// поэтому на пачку из BATCH_SIZE запросов приходится два системных вызова.
+class UdpEndpoint {
+private:
+    Logger& logger_;
+    Authenticator& authenticator_;
+    ClientScheduler& scheduler_;
+    bool keyByLogin_;
+
+    static const size_t BATCH_SIZE = 64;
+
+    std::vector<char> receiveBuffers_;
+    std::vector<char> sendBuffers_;
+    std::vector<struct sockaddr_in> addresses_;
+    std::vector<struct iovec> receiveIov_;
+    std::vector<struct iovec> sendIov_;
+    std::vector<struct mmsghdr> receiveMessages_;
+    std::vector<struct mmsghdr> sendMessages_;
+    std::vector<float> elements_;
+
+    uint64_t processed_;
+    uint64_t rejected_;
+
+public:
+    UdpEndpoint(Logger& logger, Authenticator& authenticator, ClientScheduler& scheduler, bool keyByLogin);
+
+    // Обрабатывает все накопившиеся датаграммы; возвращает их количество
+    size_t processPending(int udpSocket);
+
+    uint64_t processed() const { return processed_; }
+    uint64_t rejected() const { return rejected_; }
+
+private:
+    void allocateBuffers();
+    uint32_t handleDatagram(const char* data, size_t size, const struct sockaddr_in& source,
+                            uint64_t now, uint32_t& requestId, float& product);
+};
+
+#endif // UDP_ENDPOINT_H
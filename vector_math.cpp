@@ -0,0 +1,252 @@
+#include "vector_math.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <endian.h>
+
+// Число независимых частичных произведений в ядрах вещественных типов:
+// 8 double или float заполняют регистры AVX и по два регистра SSE
+static const size_t PRODUCT_LANES = 8;
+
+// Функция для проверки переполнения при умножении
+bool checkMultiplicationOverflow(float a, float b) {
+    if (a == 0.0f || b == 0.0f) {
+        return false;
+    }
+    
+    float max_value = std::numeric_limits<float>::max();
+    float min_value = std::numeric_limits<float>::lowest();
+    
+    // Проверка переполнения вверх (a * b > max_value)
+    if (a > 0 && b > 0) {
+        return a > max_value / b;
+    }
+    // Проверка переполнения вниз (a * b < min_value)  
+    else if (a < 0 && b < 0) {
+        return a < max_value / b;
+    }
+    // Проверка отрицательного переполнения
+    else if (a > 0 && b < 0) {
+        return b < min_value / a;
+    }
+    else if (a < 0 && b > 0) {
+        return a < min_value / b;
+    }
+    
+    return false;
+}
+
+// Функция для вычисления произведения с проверкой переполнения
+float calculateProductWithOverflowCheck(const float* data, size_t size, Logger& logger) {
+    if (size == 0) {
+        return 0.0f;
+    }
+    
+    float product = 1.0f;
+    
+    for (size_t i = 0; i < size; ++i) {
+        float value = data[i];
+        
+        // Проверка на переполнение перед умножением
+        if (checkMultiplicationOverflow(product, value)) {
+            logger.warning("Overflow detected in vector product calculation");
+            return -std::numeric_limits<float>::infinity(); // -inf согласно ТЗ
+        }
+        
+        product *= value;
+        
+        // Проверка на переполнение после умножения
+        if (std::isinf(product)) {
+            logger.warning("Overflow occurred in vector product calculation");
+            return -std::numeric_limits<float>::infinity(); // -inf согласно ТЗ
+        }
+    }
+    
+    return product;
+}
+
+float calculateProductWithOverflowCheck(const std::vector<float>& vector, Logger& logger) {
+    return calculateProductWithOverflowCheck(vector.data(), vector.size(), logger);
+}
+
+template <typename Acc, typename Load>
+static Acc laneProduct(size_t size, Load load) {
+    if (size == 0) {
+        return 0;
+    }
+    
+    Acc lanes[PRODUCT_LANES];
+    for (size_t j = 0; j < PRODUCT_LANES; ++j) {
+        lanes[j] = 1;
+    }
+    
+    size_t i = 0;
+    for (; i + PRODUCT_LANES <= size; i += PRODUCT_LANES) {
+        for (size_t j = 0; j < PRODUCT_LANES; ++j) {
+            lanes[j] *= load(i + j);
+        }
+    }
+    for (; i < size; ++i) {
+        lanes[0] *= load(i);
+    }
+    
+    Acc product = 1;
+    bool overflow = false;
+    for (size_t j = 0; j < PRODUCT_LANES; ++j) {
+        overflow = overflow || std::isinf(lanes[j]);
+        product *= lanes[j];
+    }
+    overflow = overflow || std::isinf(product);
+    
+    // NaN без NaN во входных данных - бесконечность, умноженная на ноль
+    if (!overflow && std::isnan(product)) {
+        overflow = true;
+        for (size_t k = 0; k < size && overflow; ++k) {
+            overflow = !std::isnan(load(k));
+        }
+    }
+    return overflow ? -std::numeric_limits<Acc>::infinity() : product;
+}
+
+// Минимальное значение типа остается ответом при переполнении, но само по
+// себе его не означает: это и обычное произведение (например, -2^31 * 1)
+template <typename T>
+static bool checkedProduct(const T* data, size_t size, T& product) {
+    if (size == 0) {
+        product = 0;
+        return true;
+    }
+    
+    product = 1;
+    for (size_t i = 0; i < size; ++i) {
+        if (__builtin_mul_overflow(product, data[i], &product)) {
+            for (size_t j = i + 1; j < size; ++j) {
+                if (data[j] == 0) {
+                    product = 0;
+                    return true;
+                }
+            }
+            product = std::numeric_limits<T>::min();
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool calculateProduct(const T* data, size_t size, T& product) {
+    if constexpr (std::is_floating_point<T>::value) {
+        product = laneProduct<T>(size, [data](size_t i) { return data[i]; });
+        return !std::isinf(product);
+    } else {
+        return checkedProduct(data, size, product);
+    }
+}
+
+template bool calculateProduct<double>(const double* data, size_t size, double& product);
+template bool calculateProduct<int32_t>(const int32_t* data, size_t size, int32_t& product);
+template bool calculateProduct<int64_t>(const int64_t* data, size_t size, int64_t& product);
+
+float calculateProductBfloat16(const uint16_t* data, size_t size) {
+    return laneProduct<float>(size, [data](size_t i) {
+        uint32_t bits = static_cast<uint32_t>(le16toh(data[i])) << 16;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    });
+}
+
+template <typename T>
+static void loadLittleEndian(const void* data, size_t count, std::vector<T>& values) {
+    values.resize(count);
+    std::memcpy(values.data(), data, count * sizeof(T));
+#if __BYTE_ORDER == __BIG_ENDIAN
+    for (T& value : values) {
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(&value);
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+#endif
+}
+
+template <typename T>
+static void storeLittleEndian(T value, void* result) {
+#if __BYTE_ORDER == __BIG_ENDIAN
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(&value);
+    std::reverse(bytes, bytes + sizeof(T));
+#endif
+    std::memcpy(result, &value, sizeof(T));
+}
+
+bool calculateProduct(ElementType type, const void* data, size_t count, void* result, Logger& logger) {
+    // На little-endian хосте данные пакета выровнены и используются без копирования
+    const bool native = __BYTE_ORDER == __LITTLE_ENDIAN;
+    bool inRange = true;
+    
+    switch (type) {
+        case ElementType::FLOAT32: {
+            std::vector<float> values;
+            if (!native) {
+                loadLittleEndian(data, count, values);
+            }
+            const float* elements = native ? static_cast<const float*>(data) : values.data();
+            float product = calculateProductWithOverflowCheck(elements, count, logger);
+            inRange = !std::isinf(product);
+            storeLittleEndian(product, result);
+            break;
+        }
+        case ElementType::FLOAT64: {
+            std::vector<double> values;
+            if (!native) {
+                loadLittleEndian(data, count, values);
+            }
+            double product;
+            inRange = calculateProduct(native ? static_cast<const double*>(data) : values.data(), count, product);
+            if (!inRange) {
+                logger.warning("Overflow detected in vector product calculation");
+            }
+            storeLittleEndian(product, result);
+            break;
+        }
+        case ElementType::INT32: {
+            std::vector<int32_t> values;
+            if (!native) {
+                loadLittleEndian(data, count, values);
+            }
+            int32_t product;
+            inRange = calculateProduct(native ? static_cast<const int32_t*>(data) : values.data(), count, product);
+            if (!inRange) {
+                logger.warning("Overflow detected in vector product calculation");
+            }
+            storeLittleEndian(product, result);
+            break;
+        }
+        case ElementType::INT64: {
+            std::vector<int64_t> values;
+            if (!native) {
+                loadLittleEndian(data, count, values);
+            }
+            int64_t product;
+            inRange = calculateProduct(native ? static_cast<const int64_t*>(data) : values.data(), count, product);
+            if (!inRange) {
+                logger.warning("Overflow detected in vector product calculation");
+            }
+            storeLittleEndian(product, result);
+            break;
+        }
+        case ElementType::BFLOAT16: {
+            // le16toh внутри ядра: порядок байтов учитывается без копии
+            float product = calculateProductBfloat16(static_cast<const uint16_t*>(data), count);
+            inRange = !std::isinf(product);
+            if (!inRange) {
+                logger.warning("Overflow detected in vector product calculation");
+            }
+            storeLittleEndian(product, result);
+            break;
+        }
+        default:
+            break;
+    }
+    return inRange;
+}
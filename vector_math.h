@@ -0,0 +1,32 @@
+#ifndef VECTOR_MATH_H
+#define VECTOR_MATH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "logger.h"
+#include "protocol.h"
+
+// Проверка переполнения при умножении
+bool checkMultiplicationOverflow(float a, float b);
+
+// Произведение элементов вектора; при переполнении возвращает -inf
+float calculateProductWithOverflowCheck(const float* data, size_t size, Logger& logger);
+float calculateProductWithOverflowCheck(const std::vector<float>& vector, Logger& logger);
+
+// Ядра для остальных типов протокола v2; false - было переполнение.
+// Вещественные типы перемножаются в нескольких независимых частичных
+// произведениях, которые компилятор раскладывает по SIMD-регистрам;
+// переполнение - если частичное или итоговое произведение вышло за диапазон
+// типа (результат -inf). Целые перемножаются с проверкой каждого шага;
+// при переполнении результат - минимальное значение типа, если в векторе
+// нет нуля (с нулем точный ответ 0 и переполнения нет).
+template <typename T>
+bool calculateProduct(const T* data, size_t size, T& product);
+float calculateProductBfloat16(const uint16_t* data, size_t size);
+
+// Произведение count элементов типа type (little-endian) записывается
+// в result как resultWidth(type) байт little-endian; false - переполнение
+bool calculateProduct(ElementType type, const void* data, size_t count, void* result, Logger& logger);
+
+#endif // VECTOR_MATH_H
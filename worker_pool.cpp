@@ -0,0 +1,86 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(size_t threadCount, std::function<void(size_t)> threadInit)
+    : stopping_(false), targetSize_(0), size_(0), threadInit_(std::move(threadInit)) {
+    resize(threadCount);
+}
+
+WorkerPool::~WorkerPool() {
+    std::lock_guard<std::mutex> resizeLock(resizeMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+size_t WorkerPool::queued() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void WorkerPool::resize(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    std::lock_guard<std::mutex> resizeLock(resizeMutex_);
+    size_t current = threads_.size();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        targetSize_ = threadCount;
+    }
+
+    if (threadCount > current) {
+        for (size_t i = current; i < threadCount; ++i) {
+            threads_.emplace_back(&WorkerPool::workerLoop, this, i);
+        }
+    } else if (threadCount < current) {
+        condition_.notify_all();
+        for (size_t i = threadCount; i < current; ++i) {
+            threads_[i].join();
+        }
+        threads_.resize(threadCount);
+    }
+    size_.store(threadCount, std::memory_order_relaxed);
+}
+
+void WorkerPool::workerLoop(size_t index) {
+    if (threadInit_) {
+        threadInit_(index);
+    }
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this, index] {
+                return stopping_ || !tasks_.empty() || index >= targetSize_;
+            });
+            if (index >= targetSize_) {
+                // Пробуждение могло предназначаться для задачи - передаем его дальше
+                if (!tasks_.empty()) {
+                    condition_.notify_one();
+                }
+                return;
+            }
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков для вычислительной стадии. Задачи выполняются в порядке
+// поступления; результаты отдаются клиенту по мере готовности.
+class WorkerPool {
+private:
+    std::vector<std::thread> threads_;  // Меняется только под resizeMutex_
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::mutex resizeMutex_;
+    std::condition_variable condition_;
+    bool stopping_;
+    size_t targetSize_;  // Потоки с номером >= targetSize_ завершаются
+    std::atomic<size_t> size_;
+    std::function<void(size_t)> threadInit_;
+
+public:
+    // threadInit вызывается в каждом новом потоке с его номером
+    // до начала работы (например, для привязки к процессору)
+    explicit WorkerPool(size_t threadCount, std::function<void(size_t)> threadInit = nullptr);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> task);
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t queued();
+
+    // Меняет число потоков на лету. Лишние потоки дорабатывают текущую
+    // задачу и завершаются; вызов ждет их завершения.
+    void resize(size_t threadCount);
+
+private:
+    void workerLoop(size_t index);
+};
+
+#endif // WORKER_POOL_H